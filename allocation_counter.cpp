@@ -0,0 +1,97 @@
+#include <cstdlib>
+#include <new>
+#include "allocation_counter.hpp"
+
+/*
+Replacement global allocation functions that count every heap allocation.
+They live in their own translation unit: a replacement may be defined only
+once per program, and keeping the new/delete pairs out of line stops the
+compiler from matching inlined deletes against its built-in operator new.
+*/
+
+std::atomic<std::uint64_t> heapAllocations{0};
+
+static void *allocate(std::size_t size) noexcept
+{
+    heapAllocations.fetch_add(1, std::memory_order_relaxed);
+    return std::malloc(size ? size : 1);
+}
+
+static void *allocateAligned(std::size_t size, std::align_val_t alignment) noexcept
+{
+    heapAllocations.fetch_add(1, std::memory_order_relaxed);
+    std::size_t align = static_cast<std::size_t>(alignment);
+#ifdef _WIN32
+    return _aligned_malloc(size ? size : 1, align);
+#else
+    // aligned_alloc wants a size that is a multiple of the alignment
+    std::size_t rounded = ((size ? size : 1) + align - 1) & ~(align - 1);
+    return std::aligned_alloc(align, rounded);
+#endif
+}
+
+static void release(void *p) noexcept { std::free(p); }
+
+static void releaseAligned(void *p) noexcept
+{
+#ifdef _WIN32
+    _aligned_free(p);
+#else
+    std::free(p);
+#endif
+}
+
+void *operator new(std::size_t size)
+{
+    if (void *p = allocate(size))
+        return p;
+    throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size)
+{
+    if (void *p = allocate(size))
+        return p;
+    throw std::bad_alloc();
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept { return allocate(size); }
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept { return allocate(size); }
+
+void *operator new(std::size_t size, std::align_val_t alignment)
+{
+    if (void *p = allocateAligned(size, alignment))
+        return p;
+    throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size, std::align_val_t alignment)
+{
+    if (void *p = allocateAligned(size, alignment))
+        return p;
+    throw std::bad_alloc();
+}
+
+void *operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept
+{
+    return allocateAligned(size, alignment);
+}
+
+void *operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept
+{
+    return allocateAligned(size, alignment);
+}
+
+void operator delete(void *p) noexcept { release(p); }
+void operator delete[](void *p) noexcept { release(p); }
+void operator delete(void *p, std::size_t) noexcept { release(p); }
+void operator delete[](void *p, std::size_t) noexcept { release(p); }
+void operator delete(void *p, const std::nothrow_t &) noexcept { release(p); }
+void operator delete[](void *p, const std::nothrow_t &) noexcept { release(p); }
+
+void operator delete(void *p, std::align_val_t) noexcept { releaseAligned(p); }
+void operator delete[](void *p, std::align_val_t) noexcept { releaseAligned(p); }
+void operator delete(void *p, std::size_t, std::align_val_t) noexcept { releaseAligned(p); }
+void operator delete[](void *p, std::size_t, std::align_val_t) noexcept { releaseAligned(p); }
+void operator delete(void *p, std::align_val_t, const std::nothrow_t &) noexcept { releaseAligned(p); }
+void operator delete[](void *p, std::align_val_t, const std::nothrow_t &) noexcept { releaseAligned(p); }
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+/*
+Heap allocation counter. allocation_counter.cpp replaces the global allocation
+functions (aligned ones included) so every heap allocation in the program,
+including the ones made inside SFML and the standard library, is counted.
+Programs that read the counter link allocation_counter.cpp exactly once.
+*/
+
+/**
+ * Total number of heap allocations since the program started
+ */
+extern std::atomic<std::uint64_t> heapAllocations;
@@ -0,0 +1,254 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include "mapped_file.hpp"
+
+/*
+Asset archives bundle every image and font into one file, so a cold start opens
+and maps one file instead of reading one per asset:
+
+    Header
+    Entry entries[entryCount]         sorted by path, so lookups are a binary search
+    char paths[pathBytes]             entry paths, not null-terminated
+    file contents                     each starting on an Alignment boundary
+
+Paths are stored the way the game asks for them ("assets/fire.png"). Assets are
+decoded straight out of the mapping with SFML's loadFromMemory().
+*/
+
+/**
+ * AssetArchive maps a packed asset archive and finds files in it by path
+ * An archive that is not open finds nothing, so callers fall back to loose files
+ */
+class AssetArchive
+{
+public:
+    static constexpr std::uint32_t FormatVersion = 1;
+    static constexpr size_t Alignment = 16;
+
+    /**
+     * File header of an archive
+     */
+    struct Header
+    {
+        char magic[4];            // "LAAR"
+        std::uint32_t version;    // FormatVersion
+        std::uint32_t entryCount; // Files in the archive
+        std::uint32_t pathBytes;  // Size of the path block
+    };
+
+    /**
+     * Index entry of one file
+     */
+    struct Entry
+    {
+        std::uint64_t offset;     // Start of the contents from the start of the archive
+        std::uint64_t size;       // Bytes of contents
+        std::uint32_t pathOffset; // Start of the path in the path block
+        std::uint32_t pathLength; // Bytes of path
+    };
+
+    /**
+     * Contents of one file, pointing into the mapping (data is null if the file was not found)
+     */
+    struct Blob
+    {
+        const char *data = nullptr;
+        size_t size = 0;
+    };
+
+private:
+    MappedFile file;
+    const Header *header = nullptr; // Null unless a valid archive is mapped
+    const Entry *entries = nullptr;
+    const char *paths = nullptr;
+
+    std::string_view pathOf(const Entry &entry) const { return std::string_view(paths + entry.pathOffset, entry.pathLength); }
+
+    static size_t dataOffset(size_t entryCount, size_t pathBytes)
+    {
+        size_t end = sizeof(Header) + entryCount * sizeof(Entry) + pathBytes;
+        return (end + Alignment - 1) & ~(Alignment - 1);
+    }
+
+    /**
+     * Point the accessors at the mapping if it is a well-formed archive
+     */
+    bool attach()
+    {
+        if (file.size() < sizeof(Header))
+            return false;
+        const Header *h = reinterpret_cast<const Header *>(file.data());
+        if (std::memcmp(h->magic, "LAAR", 4) != 0 || h->version != FormatVersion ||
+            dataOffset(h->entryCount, h->pathBytes) > file.size())
+            return false;
+
+        const Entry *e = reinterpret_cast<const Entry *>(file.data() + sizeof(Header));
+        const char *p = reinterpret_cast<const char *>(e + h->entryCount);
+
+        // Bounds-check every entry so a corrupt archive can never be read out of range
+        for (std::uint32_t i = 0; i < h->entryCount; ++i)
+        {
+            if (size_t(e[i].pathOffset) + e[i].pathLength > h->pathBytes || e[i].offset > file.size() ||
+                e[i].size > file.size() - e[i].offset)
+                return false;
+            if (i > 0 && !(std::string_view(p + e[i - 1].pathOffset, e[i - 1].pathLength) <
+                           std::string_view(p + e[i].pathOffset, e[i].pathLength)))
+                return false;
+        }
+
+        header = h;
+        entries = e;
+        paths = p;
+        return true;
+    }
+
+    static bool readFile(const std::string &path, std::vector<char> &data)
+    {
+        std::ifstream in(path, std::ios::binary);
+        if (!in)
+            return false;
+        data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        return true;
+    }
+
+    template <typename T>
+    static void append(std::vector<char> &out, const T &value)
+    {
+        const char *bytes = reinterpret_cast<const char *>(&value);
+        out.insert(out.end(), bytes, bytes + sizeof(T));
+    }
+
+public:
+    AssetArchive() = default;
+    AssetArchive(const AssetArchive &) = delete;
+    AssetArchive &operator=(const AssetArchive &) = delete;
+
+    /**
+     * Open an archive that may not exist (an empty path or a missing file leaves it closed)
+     */
+    explicit AssetArchive(const std::string &path)
+    {
+        if (!path.empty())
+            open(path);
+    }
+
+    /**
+     * Map an archive, replacing any archive opened before
+     * Returns false if it is missing or not a valid archive
+     */
+    bool open(const std::string &path)
+    {
+        header = nullptr;
+        if (!file.open(path))
+        {
+            std::cerr << "Failed to open asset archive: " << path << ", using loose files\n";
+            return false;
+        }
+        if (!attach())
+        {
+            std::cerr << "Ignoring invalid or outdated asset archive: " << path << "\n";
+            file.close();
+            return false;
+        }
+        return true;
+    }
+
+    bool isOpen() const { return header != nullptr; }
+    size_t getCount() const { return header ? header->entryCount : 0; }
+
+    /**
+     * Contents of a file in the archive
+     * The bytes stay valid for as long as the archive is open
+     */
+    Blob find(std::string_view path) const
+    {
+        if (!header)
+            return {};
+        const Entry *end = entries + header->entryCount;
+        const Entry *it = std::lower_bound(entries, end, path, [&](const Entry &entry, std::string_view key)
+                                           { return pathOf(entry) < key; });
+        if (it == end || pathOf(*it) != path)
+            return {};
+        return {file.data() + it->offset, static_cast<size_t>(it->size)};
+    }
+
+    /**
+     * Pack files into a new archive (each is stored under its path as given)
+     * Returns false if a file cannot be read or the archive cannot be written
+     */
+    static bool write(const std::string &archivePath, std::vector<std::string> files)
+    {
+        std::sort(files.begin(), files.end());
+        files.erase(std::unique(files.begin(), files.end()), files.end());
+
+        std::vector<std::vector<char>> contents(files.size());
+        size_t pathBytes = 0;
+        for (size_t i = 0; i < files.size(); ++i)
+        {
+            if (!readFile(files[i], contents[i]))
+            {
+                std::cerr << "Failed to read asset: " << files[i] << "\n";
+                return false;
+            }
+            pathBytes += files[i].size();
+        }
+
+        Header h;
+        std::memcpy(h.magic, "LAAR", 4);
+        h.version = FormatVersion;
+        h.entryCount = static_cast<std::uint32_t>(files.size());
+        h.pathBytes = static_cast<std::uint32_t>(pathBytes);
+
+        std::vector<char> out;
+        append(out, h);
+        size_t offset = dataOffset(files.size(), pathBytes);
+        std::uint32_t pathOffset = 0;
+        for (size_t i = 0; i < files.size(); ++i)
+        {
+            append(out, Entry{offset, contents[i].size(), pathOffset, static_cast<std::uint32_t>(files[i].size())});
+            offset = (offset + contents[i].size() + Alignment - 1) & ~(Alignment - 1);
+            pathOffset += static_cast<std::uint32_t>(files[i].size());
+        }
+        for (const std::string &path : files)
+            out.insert(out.end(), path.begin(), path.end());
+        for (const std::vector<char> &data : contents)
+        {
+            out.resize((out.size() + Alignment - 1) & ~(Alignment - 1));
+            out.insert(out.end(), data.begin(), data.end());
+        }
+
+        std::string tempPath = archivePath + ".tmp";
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        file.write(out.data(), static_cast<std::streamsize>(out.size()));
+        file.close();
+        if (!file || !replaceFile(tempPath, archivePath))
+        {
+            std::cerr << "Failed to write asset archive: " << archivePath << "\n";
+            std::remove(tempPath.c_str());
+            return false;
+        }
+        return true;
+    }
+};
+
+/**
+ * Load an SFML resource (image, texture, font) from an archive, or from the loose
+ * file when there is no archive or it does not have the path
+ * Fonts read glyphs from the memory they were loaded from, which the archive keeps mapped
+ */
+template <typename Resource>
+bool loadAsset(const AssetArchive *archive, const std::string &path, Resource &resource)
+{
+    AssetArchive::Blob blob = archive ? archive->find(path) : AssetArchive::Blob();
+    return blob.data ? resource.loadFromMemory(blob.data, blob.size) : resource.loadFromFile(path);
+}
@@ -0,0 +1,346 @@
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+#include <sys/resource.h>
+#include "simulation.hpp"
+#include "recipe_explorer.hpp"
+#include "allocation_counter.hpp"
+
+/*
+Headless throughput benchmark for the simulation core (no window or display server needed).
+
+Compilation instructions:
+g++ -c allocation_counter.cpp -o allocation_counter.o -std=c++17 -O2
+g++ -c bench.cpp -o bench.o -std=c++17 -O2 -pthread
+g++ bench.o allocation_counter.o -o bench -pthread
+
+Usage:
+./bench [--objects N] [--ops N] [--seed N] [--pack path] [--max-allocs N]
+
+--max-allocs fails the run (exit status 1) if the steady-state half of the ops
+makes more than N heap allocations.
+*/
+
+/**
+ * Latency samples of one kind of operation, in nanoseconds
+ */
+class LatencyStats
+{
+    std::vector<double> samples;
+
+public:
+    void add(double ns) { samples.push_back(ns); }
+    void reserve(size_t n) { samples.reserve(n); } // Keeps the samples out of the allocation count
+    size_t count() const { return samples.size(); }
+
+    /**
+     * Percentile (0-100) of the recorded samples
+     */
+    double percentile(double p)
+    {
+        if (samples.empty())
+            return 0.0;
+        size_t rank = static_cast<size_t>(p / 100.0 * (samples.size() - 1));
+        std::nth_element(samples.begin(), samples.begin() + rank, samples.end());
+        return samples[rank];
+    }
+
+    void report(const std::string &name)
+    {
+        std::cout << std::left << std::setw(10) << name << std::right
+                  << " count " << std::setw(9) << count()
+                  << "  p50 " << std::setw(9) << std::fixed << std::setprecision(0) << percentile(50) << " ns"
+                  << "  p99 " << std::setw(9) << percentile(99) << " ns\n";
+    }
+};
+
+/**
+ * Synthetic workload replaying spawn / drag / drop / combine operations against a Simulation
+ */
+class Benchmark
+{
+    Simulation sim;
+    std::mt19937 rng;
+    size_t targetObjects;
+    float worldSize; // Side of the square world area objects are spawned in
+    float time = 0.0f;
+
+    LatencyStats spawnStats;
+    LatencyStats pickStats;
+    LatencyStats previewStats;
+    LatencyStats dropStats;
+    LatencyStats updateStats;
+    LatencyStats visibleStats;
+    std::mt19937 cameraRng;      // Separate from rng so culling leaves the workload unchanged
+    std::vector<size_t> visible; // Objects inside the last camera query
+    size_t visibleTotal = 0;
+    size_t combines = 0;
+    size_t invalidDrops = 0;
+    std::uint64_t steadyAllocations = 0; // Heap allocations during the second half of the ops
+
+    using Clock = std::chrono::steady_clock;
+
+    static double elapsedNs(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    }
+
+    sf::Vector2f randomPosition()
+    {
+        std::uniform_real_distribution<float> coord(0.0f, worldSize);
+        return sf::Vector2f(coord(rng), coord(rng));
+    }
+
+    ElementId randomElement()
+    {
+        std::uniform_int_distribution<size_t> pick(0, sim.elements.size() - 1);
+        return static_cast<ElementId>(pick(rng));
+    }
+
+    void spawnOne()
+    {
+        ElementId element = randomElement();
+        sf::Vector2f pos = randomPosition();
+        auto start = Clock::now();
+        sim.spawn(element, pos, time);
+        spawnStats.add(elapsedNs(start));
+    }
+
+    /**
+     * Pick a random object, drag it and drop it - half of the time onto another
+     * random object (a combine attempt), otherwise onto a random spot so objects
+     * do not all end up in a few piles
+     */
+    void dragAndDrop()
+    {
+        std::uniform_int_distribution<size_t> pickIndex(0, sim.objects.size() - 1);
+        size_t from = pickIndex(rng);
+        sf::FloatRect fromBounds = sim.objectBounds(from);
+        sf::Vector2f target = (rng() & 1) ? sim.objects.positions[pickIndex(rng)] + sf::Vector2f(10.0f, 10.0f)
+                                          : randomPosition();
+
+        // Pick by clicking the centre of the object, like the mouse handler does
+        sf::Vector2f click(fromBounds.left + fromBounds.width / 2, fromBounds.top + fromBounds.height / 2);
+        auto start = Clock::now();
+        ObjectHandle picked = sim.pick(click);
+        pickStats.add(elapsedNs(start));
+        if (picked.isNull())
+            return;
+
+        start = Clock::now();
+        sim.beginDrag(picked);
+        sim.dragTo(target);
+        double dragNs = elapsedNs(start);
+
+        // The hover preview the game computes on every frame of a drag (not part of the drop time)
+        start = Clock::now();
+        sim.previewDrop();
+        previewStats.add(elapsedNs(start));
+
+        start = Clock::now();
+        ObjectHandle dropped = sim.endDrag();
+        DropResult drop = sim.checkCollisions(dropped, time);
+        dropStats.add(dragNs + elapsedNs(start));
+
+        if (drop.combined)
+            combines++;
+        else if (drop.invalid)
+            invalidDrops++;
+    }
+
+public:
+    Benchmark(size_t objects, unsigned seed, const std::string &packPath)
+        : sim(objects, packPath), rng(seed), targetObjects(objects), cameraRng(seed)
+    {
+        // Keep object density roughly constant so overlap rates do not depend on N
+        worldSize = std::sqrt(static_cast<float>(std::max<size_t>(objects, 1))) * Simulation::DefaultObjectSize * 1.5f;
+    }
+
+    void run(size_t ops)
+    {
+        for (LatencyStats *stats : {&spawnStats, &pickStats, &previewStats, &dropStats, &updateStats, &visibleStats})
+            stats->reserve(targetObjects + ops);
+        visible.reserve(sim.getMaxObjects()); // A camera never sees more objects than the sandbox holds
+
+        // Populate the sandbox
+        for (size_t i = 0; i < targetObjects; ++i)
+            spawnOne();
+
+        auto start = Clock::now();
+        std::uint64_t allocationsBefore = 0;
+        for (size_t op = 0; op < ops; ++op)
+        {
+            // The first half warms up the pools and scratch buffers; the second half is the steady state
+            if (op == ops / 2)
+                allocationsBefore = heapAllocations.load(std::memory_order_relaxed);
+            time += 1.0f / 60.0f;
+
+            // Keep the population near the target: combines shrink it, spawns refill it
+            if (sim.objects.size() < 2 || sim.objects.size() < targetObjects)
+                spawnOne();
+            else
+                dragAndDrop();
+
+            auto updateStart = Clock::now();
+            sim.update(time);
+            updateStats.add(elapsedNs(updateStart));
+
+            // Cull the world to a window-sized camera somewhere in it, as the game does before drawing
+            std::uniform_real_distribution<float> coord(0.0f, worldSize);
+            sf::Vector2f camera(coord(cameraRng), coord(cameraRng));
+            auto visibleStart = Clock::now();
+            sim.queryArea(sf::FloatRect(camera.x, camera.y, 700, 600), visible);
+            visibleStats.add(elapsedNs(visibleStart));
+            visibleTotal += visible.size();
+        }
+        double seconds = elapsedNs(start) / 1e9;
+        steadyAllocations = heapAllocations.load(std::memory_order_relaxed) - allocationsBefore;
+
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+
+        std::cout << "objects " << targetObjects << ", ops " << ops << ", " << std::fixed << std::setprecision(3)
+                  << seconds << " s\n";
+        spawnStats.report("spawn");
+        pickStats.report("pick");
+        previewStats.report("preview");
+        dropStats.report("drop");
+        updateStats.report("update");
+        visibleStats.report("visible");
+        std::cout << "visible objects per camera " << std::setprecision(1) << double(visibleTotal) / std::max<size_t>(ops, 1) << "\n";
+        std::cout << "combines " << combines << " (" << std::setprecision(0) << combines / seconds << "/s)"
+                  << ", invalid drops " << invalidDrops
+                  << ", ops/s " << ops / seconds << "\n";
+        std::cout << "steady-state heap allocations " << steadyAllocations << " in " << ops - ops / 2 << " ops\n";
+        std::cout << "peak memory " << std::setprecision(1) << usage.ru_maxrss / 1024.0 << " MiB\n";
+
+        measureSaveRestore();
+        measureCombineAll();
+        measureExplorer();
+    }
+
+    /**
+     * Time one "combine all" pass over the final sandbox
+     */
+    void measureCombineAll()
+    {
+        size_t objectsBefore = sim.objects.size();
+        auto start = Clock::now();
+        CombineAllResult combined = sim.combineAll(time);
+        double ms = elapsedNs(start) / 1e6;
+        std::cout << "combine all " << std::setprecision(2) << ms << " ms (" << combined.combined << " merges, "
+                  << objectsBefore << " -> " << sim.objects.size() << " objects)\n";
+    }
+
+    std::uint64_t getSteadyAllocations() const { return steadyAllocations; }
+    size_t getElementCount() const { return sim.elements.size(); }
+
+    /**
+     * Time the recipe graph searches the game runs: the pack check from the basic
+     * elements at load time and the hint from the current discoveries
+     */
+    void measureExplorer()
+    {
+        auto start = Clock::now();
+        RecipeExplorer explorer;
+        explorer.build(sim.registry, sim.elements.size());
+        double buildMs = elapsedNs(start) / 1e6;
+
+        std::vector<ElementId> basics;
+        for (size_t i = 0; i < sim.elements.size(); ++i)
+        {
+            if (sim.pack.isBasic(i))
+                basics.push_back(static_cast<ElementId>(i));
+        }
+        start = Clock::now();
+        RecipeExplorer::Result full = explorer.explore(basics);
+        double exploreMs = elapsedNs(start) / 1e6;
+
+        start = Clock::now();
+        RecipeExplorer::Hint hint = explorer.hint(sim.getDiscoveredSet());
+        double hintMs = elapsedNs(start) / 1e6;
+
+        std::cout << "explore " << std::setprecision(2) << buildMs << " ms index + " << exploreMs << " ms search ("
+                  << full.reachable << "/" << sim.elements.size() << " reachable, " << full.deadFormulas.size()
+                  << " dead recipes), hint " << hintMs << " ms ("
+                  << (hint.isValid() ? sim.elements[hint.result]->name : std::string("none")) << ")\n";
+        explorer.report(full, sim.elements, std::cout);
+    }
+
+    /**
+     * Time a save file round trip of the final sandbox: snapshot, write, read and restore
+     */
+    void measureSaveRestore()
+    {
+        const std::string path = "bench_save.tmp";
+        size_t objectsBefore = sim.objects.size();
+
+        auto start = Clock::now();
+        SaveState saved = sim.snapshot();
+        double snapshotMs = elapsedNs(start) / 1e6;
+
+        start = Clock::now();
+        bool written = writeSaveFile(path, saved);
+        double writeMs = elapsedNs(start) / 1e6;
+
+        start = Clock::now();
+        SaveState loaded;
+        bool read = written && readSaveFile(path, loaded);
+        double readMs = elapsedNs(start) / 1e6;
+
+        start = Clock::now();
+        if (read)
+            sim.restore(loaded, time);
+        double restoreMs = elapsedNs(start) / 1e6;
+        std::remove(path.c_str());
+
+        std::cout << "save " << std::setprecision(2) << snapshotMs << " ms snapshot + " << writeMs << " ms write"
+                  << ", restore " << readMs << " ms read + " << restoreMs << " ms rebuild ("
+                  << (read && sim.objects.size() == objectsBefore ? "ok" : "MISMATCH") << ")\n";
+    }
+};
+
+int main(int argc, char **argv)
+{
+    size_t objects = 1000;
+    size_t ops = 100000;
+    unsigned seed = 1;
+    std::string packPath = Simulation::DefaultPackPath;
+    long long maxAllocations = -1; // No limit
+    for (int i = 1; i + 1 < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--objects") == 0)
+            objects = std::strtoul(argv[++i], nullptr, 10);
+        else if (std::strcmp(argv[i], "--ops") == 0)
+            ops = std::strtoul(argv[++i], nullptr, 10);
+        else if (std::strcmp(argv[i], "--seed") == 0)
+            seed = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        else if (std::strcmp(argv[i], "--pack") == 0)
+            packPath = argv[++i];
+        else if (std::strcmp(argv[i], "--max-allocs") == 0)
+            maxAllocations = std::strtoll(argv[++i], nullptr, 10);
+    }
+
+    Benchmark bench(objects, seed, packPath);
+    if (bench.getElementCount() == 0)
+    {
+        std::cerr << "Recipe pack " << packPath << " has no elements to spawn\n";
+        return 1;
+    }
+    bench.run(ops);
+    if (maxAllocations >= 0 && bench.getSteadyAllocations() > static_cast<std::uint64_t>(maxAllocations))
+    {
+        std::cerr << "FAIL: " << bench.getSteadyAllocations() << " steady-state heap allocations, at most "
+                  << maxAllocations << " allowed\n";
+        return 1;
+    }
+    return 0;
+}
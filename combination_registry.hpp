@@ -0,0 +1,331 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <memory>
+#include <algorithm>
+#include <deque>
+#include <cstdint>
+#include "recipe_pack.hpp"
+
+/*
+Recipe engine: elements, the recipe registry and discovery bookkeeping.
+Uses no SFML at all, so headless services can share it with the game
+(see recipe_service.hpp).
+*/
+
+/**
+ * Element class represents discoverable elements in the game
+ * Each element has a name, description, discovery status, and creation count
+ */
+class Element
+{
+public:
+    std::string name;        // Element name (e.g., "Fire", "Air")
+    std::string description; // Descriptive text for the element
+    std::string texture;     // Path of the element's image
+    bool discovered;         // Whether the player has discovered this element (set through Simulation::discover())
+    int creationCount;       // How many times this element has been created
+    ElementId id;            // Dense id (index in the element list)
+
+    Element(const std::string &n, const std::string &desc, bool disc = false, const std::string &tex = "")
+        : name(n), description(desc), texture(tex), discovered(disc), creationCount(0), id(NoElement) {}
+};
+
+/**
+ * DiscoverySet tracks which elements are known: a bitset for membership tests
+ * plus the ids in the order they were added
+ */
+class DiscoverySet
+{
+    std::vector<std::uint64_t> bits; // One bit per element id
+    std::vector<ElementId> order;    // Added ids, oldest first
+
+public:
+    /**
+     * Forget every element and make room for ids below elementCount
+     */
+    void reset(size_t elementCount)
+    {
+        bits.assign((elementCount + 63) / 64, 0);
+        order.clear();
+        order.reserve(elementCount);
+    }
+
+    /**
+     * Add an element
+     * Returns true if it was not in the set before
+     */
+    bool add(ElementId element)
+    {
+        std::uint64_t bit = std::uint64_t(1) << (element % 64);
+        if (bits[element / 64] & bit)
+            return false;
+        bits[element / 64] |= bit;
+        order.push_back(element);
+        return true;
+    }
+
+    bool contains(ElementId element) const { return (bits[element / 64] >> (element % 64)) & 1; }
+
+    /**
+     * Ids in the order they were added
+     */
+    const std::vector<ElementId> &getOrder() const { return order; }
+    size_t size() const { return order.size(); }
+};
+
+/**
+ * CombinationRegistry manages valid element combinations and their results
+ * Stores recipes for creating new elements from existing ones, plus the reverse
+ * direction (which inputs make an element) and each element's recipe depth
+ * Nothing changes after build(), so any number of threads may look up recipes at once
+ */
+class CombinationRegistry
+{
+public:
+    /**
+     * The ingredients of one recipe
+     */
+    struct Formula
+    {
+        ElementId ingredients[MaxIngredients]; // As written in the pack; the first count are used
+        std::uint16_t count;                   // Number of ingredients (2 to MaxIngredients)
+
+        RecipeKey key() const { return recipeKey(ingredients, count); }
+    };
+
+    /**
+     * All formulas producing one element, usable in a range-based for loop
+     */
+    struct FormulaRange
+    {
+        const Formula *first;
+        const Formula *last;
+
+        const Formula *begin() const { return first; }
+        const Formula *end() const { return last; }
+        size_t size() const { return static_cast<size_t>(last - first); }
+        bool empty() const { return first == last; }
+    };
+
+    static constexpr int NoDepth = -1; // Depth of elements that cannot be made from the basic ones
+
+private:
+    std::unordered_map<std::string, ElementId> ids; // Interned element names
+    const RecipeSlot *table = nullptr;              // Flat hash table keyed by sorted ingredient ids (owned by the pack)
+    std::uint32_t tableMask = 0;                    // Table size - 1 (size is a power of two)
+    std::vector<std::uint32_t> formulaStart;        // Formulas of element i are formulas[formulaStart[i], formulaStart[i + 1])
+    std::vector<Formula> formulas;                  // Reverse index: recipe inputs grouped by result
+    std::vector<int> depths;                        // Fewest combination steps from the basic elements, by id
+
+    /**
+     * Group the pack's recipes by result (counting sort, so O(elements + recipes))
+     * Recipes overridden by a later one for the same ingredients are left out
+     */
+    void buildReverseIndex(size_t elementCount, const RecipePack &pack)
+    {
+        formulaStart.assign(elementCount + 1, 0);
+        formulas.clear();
+        std::vector<bool> live(pack.getRecipeCount());
+        for (size_t r = 0; r < pack.getRecipeCount(); ++r)
+        {
+            const RecipePack::RecipeRecord &recipe = pack.getRecipe(r);
+            live[r] = recipe.result < elementCount && getResult(recipe.ingredients, recipe.count) == recipe.result;
+            if (live[r])
+                formulaStart[recipe.result + 1]++;
+        }
+        for (size_t i = 0; i < elementCount; ++i)
+            formulaStart[i + 1] += formulaStart[i];
+
+        formulas.resize(formulaStart[elementCount]);
+        std::vector<std::uint32_t> fill(formulaStart.begin(), formulaStart.end() - 1);
+        for (size_t r = 0; r < pack.getRecipeCount(); ++r)
+        {
+            const RecipePack::RecipeRecord &recipe = pack.getRecipe(r);
+            if (live[r])
+            {
+                Formula &f = formulas[fill[recipe.result]++];
+                std::copy(recipe.ingredients, recipe.ingredients + MaxIngredients, f.ingredients);
+                f.count = recipe.count;
+            }
+        }
+
+        // The same ingredients may be written twice in different orders; keep each formula once
+        std::uint32_t out = 0;
+        for (size_t i = 0; i < elementCount; ++i)
+        {
+            std::uint32_t begin = formulaStart[i], end = formulaStart[i + 1];
+            std::sort(formulas.begin() + begin, formulas.begin() + end, [](const Formula &a, const Formula &b)
+                      { return a.key() < b.key(); });
+            formulaStart[i] = out;
+            for (std::uint32_t f = begin; f < end; ++f)
+            {
+                if (f == begin || formulas[f].key() != formulas[out - 1].key())
+                    formulas[out++] = formulas[f];
+            }
+        }
+        formulaStart[elementCount] = out;
+        formulas.resize(out);
+    }
+
+    /**
+     * Breadth-first search outward from the basic elements
+     * Elements leave the queue in order of depth; a recipe only completes once
+     * its deepest ingredient leaves the queue, so the first one to complete an
+     * element gives its smallest depth
+     */
+    void computeDepths(size_t elementCount, const RecipePack &pack)
+    {
+        // Forward index: which formulas use each element as an ingredient (once per formula)
+        auto firstUse = [](const Formula &f, std::uint16_t k)
+        { return std::find(f.ingredients, f.ingredients + k, f.ingredients[k]) == f.ingredients + k; };
+        std::vector<std::uint32_t> useStart(elementCount + 1, 0);
+        for (const Formula &f : formulas)
+        {
+            for (std::uint16_t k = 0; k < f.count; ++k)
+            {
+                if (firstUse(f, k))
+                    useStart[f.ingredients[k] + 1]++;
+            }
+        }
+        for (size_t i = 0; i < elementCount; ++i)
+            useStart[i + 1] += useStart[i];
+        std::vector<std::uint32_t> uses(useStart[elementCount]);
+        std::vector<std::uint32_t> fill(useStart.begin(), useStart.end() - 1);
+        std::vector<ElementId> resultOf(formulas.size());
+        for (size_t i = 0; i < elementCount; ++i)
+        {
+            for (std::uint32_t f = formulaStart[i]; f < formulaStart[i + 1]; ++f)
+            {
+                resultOf[f] = static_cast<ElementId>(i);
+                for (std::uint16_t k = 0; k < formulas[f].count; ++k)
+                {
+                    if (firstUse(formulas[f], k))
+                        uses[fill[formulas[f].ingredients[k]]++] = f;
+                }
+            }
+        }
+
+        depths.assign(elementCount, NoDepth);
+        std::deque<ElementId> frontier;
+        for (size_t i = 0; i < elementCount; ++i)
+        {
+            if (pack.isBasic(i))
+            {
+                depths[i] = 0;
+                frontier.push_back(static_cast<ElementId>(i));
+            }
+        }
+        while (!frontier.empty())
+        {
+            ElementId current = frontier.front();
+            frontier.pop_front();
+            for (std::uint32_t u = useStart[current]; u < useStart[current + 1]; ++u)
+            {
+                const Formula &f = formulas[uses[u]];
+                ElementId result = resultOf[uses[u]];
+                if (depths[result] != NoDepth)
+                    continue;
+                int deepest = 0;
+                for (std::uint16_t k = 0; k < f.count && deepest != NoDepth; ++k)
+                    deepest = depths[f.ingredients[k]] == NoDepth ? NoDepth : std::max(deepest, depths[f.ingredients[k]]);
+                if (deepest == NoDepth || deepest > depths[current])
+                    continue; // Another ingredient is not reachable yet (or is still queued, and retries this formula)
+                depths[result] = deepest + 1;
+                frontier.push_back(result);
+            }
+        }
+    }
+
+public:
+    /**
+     * Give elements their dense ids (the index of each element in the list) and
+     * use the pack's precompiled recipe table for lookups
+     * The pack must outlive the registry
+     */
+    void build(const std::vector<std::shared_ptr<Element>> &elements, const RecipePack &pack)
+    {
+        ids.clear();
+        for (size_t i = 0; i < elements.size() && i < NoElement; ++i)
+        {
+            elements[i]->id = static_cast<ElementId>(i);
+            ids[elements[i]->name] = elements[i]->id;
+        }
+
+        table = pack.getTable();
+        tableMask = pack.getTableSize() ? pack.getTableSize() - 1 : 0;
+
+        size_t elementCount = std::min<size_t>(elements.size(), NoElement);
+        buildReverseIndex(elementCount, pack);
+        computeDepths(elementCount, pack);
+    }
+
+    /**
+     * Every formula that produces an element (empty for elements no recipe makes)
+     */
+    FormulaRange getFormulas(ElementId result) const
+    {
+        if (result + 1u >= formulaStart.size())
+            return {nullptr, nullptr};
+        return {formulas.data() + formulaStart[result], formulas.data() + formulaStart[result + 1]};
+    }
+
+    /**
+     * Fewest combinations needed to make an element from the basic ones
+     * Basic elements have depth 0; unreachable elements have NoDepth
+     */
+    int getDepth(ElementId element) const
+    {
+        return element < depths.size() ? depths[element] : NoDepth;
+    }
+
+    /**
+     * Look up the dense id of an element name
+     * Returns NoElement if the name is unknown
+     */
+    ElementId getId(const std::string &name) const
+    {
+        auto it = ids.find(name);
+        return it != ids.end() ? it->second : NoElement;
+    }
+
+    /**
+     * Check if two elements can be combined together
+     */
+    bool isValidCombination(ElementId e1, ElementId e2) const
+    {
+        return getResult(e1, e2) != NoElement;
+    }
+
+    /**
+     * Get the result of combining two elements (in either order)
+     * Returns NoElement if combination is invalid
+     */
+    ElementId getResult(ElementId e1, ElementId e2) const
+    {
+        ElementId ingredients[2] = {e1, e2};
+        return getResult(ingredients, 2);
+    }
+
+    /**
+     * Get the result of combining 2 to MaxIngredients elements (in any order)
+     * One hash probe on the sorted ingredient ids, whatever the count
+     * Returns NoElement if combination is invalid
+     */
+    ElementId getResult(const ElementId *ingredients, size_t count) const
+    {
+        RecipeKey key = recipeKey(ingredients, count);
+        if (!table || key == RecipeEmptyKey)
+            return NoElement;
+
+        for (std::uint32_t slot = recipeSlotFor(key, tableMask);; slot = (slot + 1) & tableMask)
+        {
+            if (table[slot].key == key)
+                return table[slot].result;
+            if (table[slot].key == RecipeEmptyKey)
+                return NoElement;
+        }
+    }
+};
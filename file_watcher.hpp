@@ -0,0 +1,146 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <algorithm>
+#include <iostream>
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+/**
+ * FileWatcher reports watched files that were written or replaced, without polling them
+ * The directories holding the files are watched rather than the files, so editors that
+ * save by writing a new file and renaming it over the old one are seen too.
+ * Built on inotify; on other platforms open() fails and nothing is ever reported.
+ */
+class FileWatcher
+{
+    int fd = -1;                            // inotify instance (-1 if not open)
+    std::map<int, std::string> directories; // Directory of each watch descriptor, as given ("" for the working directory)
+    std::set<std::string> files;            // Paths to report, as given to watch()
+
+public:
+    FileWatcher() = default;
+    ~FileWatcher()
+    {
+#ifdef __linux__
+        if (fd >= 0)
+            ::close(fd);
+#endif
+    }
+
+    FileWatcher(const FileWatcher &) = delete;
+    FileWatcher &operator=(const FileWatcher &) = delete;
+
+    /**
+     * Start watching (no files are watched yet)
+     * Returns false if file change notification is not available
+     */
+    bool open()
+    {
+#ifdef __linux__
+        fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (fd < 0)
+            std::cerr << "Failed to start watching files for changes\n";
+        return fd >= 0;
+#else
+        std::cerr << "Watching files for changes is only supported on Linux\n";
+        return false;
+#endif
+    }
+
+    bool isOpen() const { return fd >= 0; }
+
+    /**
+     * Report changes to a file from now on (its directory is watched once for all its files)
+     */
+    bool watch(const std::string &path)
+    {
+#ifdef __linux__
+        if (fd < 0)
+            return false;
+        size_t slash = path.find_last_of('/');
+        std::string directory = slash == std::string::npos ? "" : path.substr(0, slash);
+        files.insert(path);
+        for (const auto &watched : directories)
+        {
+            if (watched.second == directory)
+                return true;
+        }
+
+        int wd = inotify_add_watch(fd, directory.empty() ? "." : directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+        if (wd < 0)
+        {
+            std::cerr << "Failed to watch directory: " << (directory.empty() ? "." : directory) << "\n";
+            return false;
+        }
+        directories[wd] = directory;
+        return true;
+#else
+        (void)path;
+        return false;
+#endif
+    }
+
+    /**
+     * Whether changes are waiting to be read with poll() (never blocks)
+     */
+    bool hasChanges() const
+    {
+#ifdef __linux__
+        pollfd ready{fd, POLLIN, 0};
+        return fd >= 0 && ::poll(&ready, 1, 0) > 0;
+#else
+        return false;
+#endif
+    }
+
+    /**
+     * Block until changes are waiting or the timeout passes
+     * Returns whether changes are waiting (false at once if the watcher is not open)
+     */
+    bool wait(int timeoutMilliseconds) const
+    {
+#ifdef __linux__
+        pollfd ready{fd, POLLIN, 0};
+        return fd >= 0 && ::poll(&ready, 1, timeoutMilliseconds) > 0;
+#else
+        (void)timeoutMilliseconds;
+        return false;
+#endif
+    }
+
+    /**
+     * Append every watched file changed since the last call to out (each once)
+     * Changes to other files in the watched directories are skipped
+     */
+    void poll(std::vector<std::string> &out)
+    {
+#ifdef __linux__
+        alignas(inotify_event) char buffer[4096];
+        ssize_t length;
+        while (fd >= 0 && (length = ::read(fd, buffer, sizeof(buffer))) > 0)
+        {
+            for (char *at = buffer; at < buffer + length;)
+            {
+                const inotify_event *event = reinterpret_cast<const inotify_event *>(at);
+                at += sizeof(inotify_event) + event->len;
+
+                auto directory = directories.find(event->wd);
+                if (event->len == 0 || directory == directories.end())
+                    continue;
+                std::string path = directory->second.empty() ? event->name : directory->second + "/" + event->name;
+                if (files.count(path) && std::find(out.begin(), out.end(), path) == out.end())
+                    out.push_back(path);
+            }
+        }
+#else
+        (void)out;
+#endif
+    }
+};
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <memory_resource>
+#include <vector>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+/**
+ * FrameArena is a bump allocator for temporaries that only live for one frame
+ * Use it through std::pmr containers (std::pmr::vector<T> v(&arena)).
+ * Allocations are carved from one buffer and never freed one by one; reset(),
+ * called once per frame, makes the whole buffer available again. A frame that
+ * needs more than the buffer takes the rest from the heap and the buffer grows
+ * at the next reset, so after a few frames every frame fits and the arena
+ * stops touching the heap.
+ */
+class FrameArena : public std::pmr::memory_resource
+{
+    /**
+     * Heap block taken when the buffer ran out (freed at the next reset)
+     */
+    struct Overflow
+    {
+        Overflow *next;
+        std::size_t alignment; // Alignment the block was allocated with
+    };
+
+    std::vector<std::byte> buffer;   // Storage handed out in order
+    std::size_t used = 0;            // Bytes of the buffer in use this frame
+    std::size_t overflowBytes = 0;   // Bytes that did not fit in the buffer this frame
+    Overflow *overflow = nullptr;    // Heap blocks of this frame, newest first
+    std::size_t peak = 0;            // Most bytes a single frame needed
+    std::uint64_t overflowCount = 0; // Heap allocations since the arena was created
+
+    static std::size_t headerSize(std::size_t alignment)
+    {
+        return (sizeof(Overflow) + alignment - 1) / alignment * alignment;
+    }
+
+    void *do_allocate(std::size_t bytes, std::size_t alignment) override
+    {
+        std::uintptr_t base = reinterpret_cast<std::uintptr_t>(buffer.data());
+        std::size_t start = ((base + used + alignment - 1) & ~(std::uintptr_t(alignment) - 1)) - base;
+        if (start + bytes <= buffer.size())
+        {
+            used = start + bytes;
+            return buffer.data() + start;
+        }
+
+        // Out of buffer: take a heap block (counted like any other) with the header in front of the returned pointer
+        alignment = std::max(alignment, alignof(Overflow));
+        std::size_t header = headerSize(alignment);
+        void *memory = alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__ ? ::operator new(header + bytes, std::align_val_t(alignment))
+                                                                    : ::operator new(header + bytes);
+        auto *block = static_cast<std::byte *>(memory);
+        overflow = new (block) Overflow{overflow, alignment};
+        overflowBytes += bytes;
+        overflowCount++;
+        return block + header;
+    }
+
+    void do_deallocate(void *, std::size_t, std::size_t) override {} // Everything goes at once in reset()
+
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override { return this == &other; }
+
+    void releaseOverflow()
+    {
+        while (overflow)
+        {
+            Overflow *next = overflow->next;
+            if (overflow->alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+                ::operator delete(overflow, std::align_val_t(overflow->alignment));
+            else
+                ::operator delete(overflow);
+            overflow = next;
+        }
+    }
+
+public:
+    explicit FrameArena(std::size_t capacity = 64 * 1024) : buffer(capacity) {}
+    ~FrameArena() override { releaseOverflow(); }
+
+    FrameArena(const FrameArena &) = delete;
+    FrameArena &operator=(const FrameArena &) = delete;
+
+    /**
+     * Start a new frame: everything allocated since the last reset becomes invalid
+     * Grows the buffer (the only time it allocates) if the last frame overflowed
+     */
+    void reset()
+    {
+        std::size_t needed = used + overflowBytes;
+        peak = std::max(peak, needed);
+        releaseOverflow();
+        if (overflowBytes > 0)
+            buffer = std::vector<std::byte>(needed * 2); // Headroom for alignment and busier frames
+        used = 0;
+        overflowBytes = 0;
+    }
+
+    std::size_t getCapacity() const { return buffer.size(); }
+    std::size_t getPeakBytes() const { return std::max(peak, used + overflowBytes); }
+    std::uint64_t getOverflowCount() const { return overflowCount; }
+};
@@ -0,0 +1,263 @@
+#pragma once
+
+#include <SFML/Graphics/Image.hpp>
+#include <SFML/System/Vector2.hpp>
+#include <vector>
+#include <string>
+#include <deque>
+#include <fstream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
+#include "asset_archive.hpp"
+
+/**
+ * Read the pixel size of a PNG from the first bytes of the file without decoding it
+ * Returns false if the bytes are too short or not a PNG
+ */
+inline bool readPngSize(const char *bytes, size_t length, sf::Vector2u &size)
+{
+    // 8-byte signature, then the IHDR chunk: 4-byte length, "IHDR", big-endian width and height
+    const unsigned char *header = reinterpret_cast<const unsigned char *>(bytes);
+    if (length < 24)
+        return false;
+
+    static const unsigned char signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    if (!std::equal(signature, signature + 8, header) || !std::equal(header + 12, header + 16, "IHDR"))
+        return false;
+
+    auto readBigEndian = [&](int offset)
+    {
+        return (unsigned(header[offset]) << 24) | (unsigned(header[offset + 1]) << 16) |
+               (unsigned(header[offset + 2]) << 8) | unsigned(header[offset + 3]);
+    };
+    size = sf::Vector2u(readBigEndian(16), readBigEndian(20));
+    return true;
+}
+
+/**
+ * Read the pixel size of a PNG, from the archive if it has the path and from the file otherwise
+ * Returns false if the file is missing or not a PNG
+ */
+inline bool readPngSize(const AssetArchive *archive, const std::string &path, sf::Vector2u &size)
+{
+    AssetArchive::Blob blob = archive ? archive->find(path) : AssetArchive::Blob();
+    if (blob.data)
+        return readPngSize(blob.data, blob.size, size);
+
+    char header[24];
+    std::ifstream file(path, std::ios::binary);
+    return file.read(header, sizeof(header)) && readPngSize(header, sizeof(header), size);
+}
+
+/**
+ * Resample an image to a new size by averaging the source area under each pixel
+ * Colours are weighted by alpha so transparent pixels don't darken the edges
+ */
+inline sf::Image resizeImage(const sf::Image &source, sf::Vector2u size)
+{
+    sf::Image result;
+    sf::Vector2u sourceSize = source.getSize();
+    if (size == sourceSize || sourceSize.x == 0 || sourceSize.y == 0)
+    {
+        result = source;
+        return result;
+    }
+    result.create(size.x, size.y, sf::Color::Transparent);
+
+    const sf::Uint8 *pixels = source.getPixelsPtr();
+    float scaleX = static_cast<float>(sourceSize.x) / size.x;
+    float scaleY = static_cast<float>(sourceSize.y) / size.y;
+    for (unsigned y = 0; y < size.y; ++y)
+    {
+        float top = y * scaleY, bottom = top + scaleY;
+        for (unsigned x = 0; x < size.x; ++x)
+        {
+            float left = x * scaleX, right = left + scaleX;
+            float r = 0, g = 0, b = 0, a = 0, area = 0;
+
+            // Sum every source pixel the target pixel overlaps, weighted by the overlap
+            for (unsigned sy = static_cast<unsigned>(top); sy < sourceSize.y && sy < bottom; ++sy)
+            {
+                float coverY = std::min(bottom, sy + 1.0f) - std::max(top, static_cast<float>(sy));
+                for (unsigned sx = static_cast<unsigned>(left); sx < sourceSize.x && sx < right; ++sx)
+                {
+                    float weight = coverY * (std::min(right, sx + 1.0f) - std::max(left, static_cast<float>(sx)));
+                    const sf::Uint8 *p = pixels + 4 * (static_cast<size_t>(sy) * sourceSize.x + sx);
+                    float alpha = weight * p[3];
+                    r += alpha * p[0];
+                    g += alpha * p[1];
+                    b += alpha * p[2];
+                    a += alpha;
+                    area += weight;
+                }
+            }
+            if (a > 0)
+                result.setPixel(x, y, sf::Color(static_cast<sf::Uint8>(r / a + 0.5f), static_cast<sf::Uint8>(g / a + 0.5f),
+                                                static_cast<sf::Uint8>(b / a + 0.5f), static_cast<sf::Uint8>(a / area + 0.5f)));
+        }
+    }
+    return result;
+}
+
+/**
+ * ImageLoader decodes image files into sf::Image on a pool of worker threads
+ * Each file is scaled on the worker to the sizes it will be drawn at, so the
+ * full-resolution pixels never leave the thread; GPU uploads stay on the main
+ * thread, which picks finished images up with collect()
+ */
+class ImageLoader
+{
+public:
+    /**
+     * One size an image is wanted at
+     */
+    struct Variant
+    {
+        std::string key;   // Key the variant is stored under (e.g. its atlas key)
+        sf::Vector2u size; // Pixel size to scale the decoded image to
+    };
+
+    /**
+     * One finished decode
+     */
+    struct Result
+    {
+        std::string path;              // File that was decoded
+        std::vector<Variant> variants; // Requested variants
+        std::vector<sf::Image> images; // Scaled pixels of each variant (empty if loading failed)
+        bool ok = false;               // Whether the file was decoded successfully
+    };
+
+private:
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake;                         // Signals workers that jobs arrived (or stopping)
+    std::condition_variable idle;                         // Signals waitIdle() that a job finished
+    std::deque<Result> jobs;                              // Queued requests (path and variants filled in)
+    std::vector<Result> finished;                         // Decoded images waiting for collect()
+    size_t inFlight = 0;                                  // Jobs currently being decoded
+    bool stopping = false;
+    const AssetArchive *archive = nullptr;                // Archive files are read from first (null for loose files only)
+
+    void work()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true)
+        {
+            wake.wait(lock, [&]
+                      { return stopping || !jobs.empty(); });
+            if (stopping)
+                return;
+
+            Result result = std::move(jobs.front());
+            jobs.pop_front();
+            inFlight++;
+            const AssetArchive *assets = archive;
+
+            // Decode and scale without holding the lock so workers run in parallel
+            lock.unlock();
+            sf::Image decoded;
+            result.ok = loadAsset(assets, result.path, decoded);
+            if (result.ok)
+            {
+                for (const Variant &variant : result.variants)
+                    result.images.push_back(resizeImage(decoded, variant.size));
+            }
+            lock.lock();
+
+            inFlight--;
+            finished.push_back(std::move(result));
+            idle.notify_all();
+        }
+    }
+
+public:
+    /**
+     * Start the worker threads (one per hardware thread by default)
+     */
+    explicit ImageLoader(unsigned threads = std::thread::hardware_concurrency())
+    {
+        threads = std::max(1u, std::min(threads, 8u));
+        for (unsigned i = 0; i < threads; ++i)
+            workers.emplace_back(&ImageLoader::work, this);
+    }
+
+    ~ImageLoader()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto &worker : workers)
+            worker.join();
+    }
+
+    ImageLoader(const ImageLoader &) = delete;
+    ImageLoader &operator=(const ImageLoader &) = delete;
+
+    /**
+     * Read files from an archive when it has them (call before the first request())
+     */
+    void setArchive(const AssetArchive *assets)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        archive = assets;
+    }
+
+    /**
+     * Queue a file to be decoded and scaled to each variant's size
+     */
+    void request(const std::string &path, std::vector<Variant> variants)
+    {
+        Result job;
+        job.path = path;
+        job.variants = std::move(variants);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            jobs.push_back(std::move(job));
+        }
+        wake.notify_one();
+    }
+
+    /**
+     * Block until every queued file has been decoded
+     */
+    void waitIdle()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        idle.wait(lock, [&]
+                  { return jobs.empty() && inFlight == 0; });
+    }
+
+    /**
+     * Whether any requested image has not been collected yet
+     */
+    bool isBusy()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return !jobs.empty() || inFlight > 0 || !finished.empty();
+    }
+
+    /**
+     * Whether decoded images are waiting for collect()
+     */
+    bool hasFinished()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return !finished.empty();
+    }
+
+    /**
+     * Take all images decoded since the last call
+     */
+    std::vector<Result> collect()
+    {
+        std::vector<Result> results;
+        std::lock_guard<std::mutex> lock(mutex);
+        results.swap(finished);
+        return results;
+    }
+};
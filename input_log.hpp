@@ -0,0 +1,273 @@
+#pragma once
+
+#include <SFML/Window/Event.hpp>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iostream>
+#include <cstdint>
+#include <cstring>
+#include "save_state.hpp"
+#include "mapped_file.hpp"
+
+/*
+Input logs record a play session so it can be replayed frame for frame:
+
+    Header
+    char initialState[stateSize]      SaveState::serialize() of the game when recording started
+    InputRecord records[]             until the end of the file
+
+Every frame of the main loop starts with a frame record holding the frame's
+game time, followed by one record per input event handled in that frame.
+*/
+
+/**
+ * One frame marker or input event, in a fixed 16 bytes
+ */
+struct InputRecord
+{
+    static constexpr std::uint8_t Frame = 0xFF; // type of frame records
+
+    std::uint8_t type;  // Frame, or the sf::Event::EventType of an event
+    std::uint8_t flags; // Key modifiers: 1 alt, 2 control, 4 shift, 8 system
+    std::uint16_t code; // Key code, mouse button or mouse wheel
+    std::int32_t x;     // Mouse x, new window width or entered character
+    std::int32_t y;     // Mouse y or new window height
+    float value;        // Frame time in seconds (frame records) or wheel delta
+};
+
+/**
+ * Pack an event into a record
+ * Returns false for event types that are not recorded (joystick, touch and sensor input)
+ */
+inline bool encodeEvent(const sf::Event &event, InputRecord &record)
+{
+    record = InputRecord{static_cast<std::uint8_t>(event.type), 0, 0, 0, 0, 0.0f};
+    switch (event.type)
+    {
+    case sf::Event::Closed:
+    case sf::Event::LostFocus:
+    case sf::Event::GainedFocus:
+    case sf::Event::MouseEntered:
+    case sf::Event::MouseLeft:
+        return true;
+    case sf::Event::Resized:
+        record.x = static_cast<std::int32_t>(event.size.width);
+        record.y = static_cast<std::int32_t>(event.size.height);
+        return true;
+    case sf::Event::TextEntered:
+        record.x = static_cast<std::int32_t>(event.text.unicode);
+        return true;
+    case sf::Event::KeyPressed:
+    case sf::Event::KeyReleased:
+        record.code = static_cast<std::uint16_t>(event.key.code);
+        record.flags = (event.key.alt ? 1 : 0) | (event.key.control ? 2 : 0) | (event.key.shift ? 4 : 0) |
+                       (event.key.system ? 8 : 0);
+        return true;
+    case sf::Event::MouseWheelScrolled:
+        record.code = static_cast<std::uint16_t>(event.mouseWheelScroll.wheel);
+        record.value = event.mouseWheelScroll.delta;
+        record.x = event.mouseWheelScroll.x;
+        record.y = event.mouseWheelScroll.y;
+        return true;
+    case sf::Event::MouseButtonPressed:
+    case sf::Event::MouseButtonReleased:
+        record.code = static_cast<std::uint16_t>(event.mouseButton.button);
+        record.x = event.mouseButton.x;
+        record.y = event.mouseButton.y;
+        return true;
+    case sf::Event::MouseMoved:
+        record.x = event.mouseMove.x;
+        record.y = event.mouseMove.y;
+        return true;
+    default:
+        return false;
+    }
+}
+
+/**
+ * Unpack an event record (see encodeEvent())
+ */
+inline sf::Event decodeEvent(const InputRecord &record)
+{
+    sf::Event event;
+    std::memset(&event, 0, sizeof(event));
+    event.type = static_cast<sf::Event::EventType>(record.type);
+    switch (event.type)
+    {
+    case sf::Event::Resized:
+        event.size.width = static_cast<unsigned>(record.x);
+        event.size.height = static_cast<unsigned>(record.y);
+        break;
+    case sf::Event::TextEntered:
+        event.text.unicode = static_cast<sf::Uint32>(record.x);
+        break;
+    case sf::Event::KeyPressed:
+    case sf::Event::KeyReleased:
+        event.key.code = static_cast<sf::Keyboard::Key>(static_cast<std::int16_t>(record.code)); // Unknown is -1
+        event.key.alt = (record.flags & 1) != 0;
+        event.key.control = (record.flags & 2) != 0;
+        event.key.shift = (record.flags & 4) != 0;
+        event.key.system = (record.flags & 8) != 0;
+        break;
+    case sf::Event::MouseWheelScrolled:
+        event.mouseWheelScroll.wheel = static_cast<sf::Mouse::Wheel>(record.code);
+        event.mouseWheelScroll.delta = record.value;
+        event.mouseWheelScroll.x = record.x;
+        event.mouseWheelScroll.y = record.y;
+        break;
+    case sf::Event::MouseButtonPressed:
+    case sf::Event::MouseButtonReleased:
+        event.mouseButton.button = static_cast<sf::Mouse::Button>(record.code);
+        event.mouseButton.x = record.x;
+        event.mouseButton.y = record.y;
+        break;
+    case sf::Event::MouseMoved:
+        event.mouseMove.x = record.x;
+        event.mouseMove.y = record.y;
+        break;
+    default:
+        break;
+    }
+    return event;
+}
+
+/**
+ * File header of an input log
+ */
+struct InputLogHeader
+{
+    static constexpr std::uint32_t FormatVersion = 1;
+
+    char magic[4];           // "LAIR"
+    std::uint32_t version;   // FormatVersion
+    std::uint32_t stateSize; // Bytes of the initial save state
+    std::uint32_t eventSize; // sizeof(InputRecord), guards against layout changes
+};
+
+/**
+ * InputRecorder streams the frames and events of a session to an input log
+ */
+class InputRecorder
+{
+    std::ofstream out;
+
+    void write(const InputRecord &record) { out.write(reinterpret_cast<const char *>(&record), sizeof(record)); }
+
+public:
+    /**
+     * Start a log with the state the session starts from
+     */
+    bool open(const std::string &path, const SaveState &initial)
+    {
+        out.open(path, std::ios::binary | std::ios::trunc);
+        if (!out)
+        {
+            std::cerr << "Failed to open input log for writing: " << path << "\n";
+            return false;
+        }
+        std::vector<char> state = initial.serialize();
+        InputLogHeader header;
+        std::memcpy(header.magic, "LAIR", 4);
+        header.version = InputLogHeader::FormatVersion;
+        header.stateSize = static_cast<std::uint32_t>(state.size());
+        header.eventSize = sizeof(InputRecord);
+        out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        out.write(state.data(), static_cast<std::streamsize>(state.size()));
+        return static_cast<bool>(out);
+    }
+
+    bool isOpen() const { return out.is_open(); }
+
+    /**
+     * Mark the start of a frame at a game time
+     */
+    void beginFrame(float time)
+    {
+        if (isOpen())
+            write({InputRecord::Frame, 0, 0, 0, 0, time});
+    }
+
+    /**
+     * Record an event handled in the current frame
+     */
+    void record(const sf::Event &event)
+    {
+        InputRecord record;
+        if (isOpen() && encodeEvent(event, record))
+            write(record);
+    }
+};
+
+/**
+ * InputReplay reads an input log back frame by frame
+ */
+class InputReplay
+{
+    std::vector<InputRecord> records;
+    size_t cursor = 0; // Next record to read
+    size_t frames = 0; // Frame records in the log
+    SaveState initial; // State the recording started from
+
+public:
+    /**
+     * Read a whole log
+     * Returns false if it is missing or not a valid log
+     */
+    bool load(const std::string &path)
+    {
+        MappedFile file;
+        InputLogHeader header;
+        if (!file.open(path) || file.size() < sizeof(header))
+        {
+            std::cerr << "Failed to read input log: " << path << "\n";
+            return false;
+        }
+        std::memcpy(&header, file.data(), sizeof(header));
+        if (std::memcmp(header.magic, "LAIR", 4) != 0 || header.version != InputLogHeader::FormatVersion ||
+            header.eventSize != sizeof(InputRecord) || sizeof(header) + header.stateSize > file.size() ||
+            !initial.deserialize(file.data() + sizeof(header), header.stateSize))
+        {
+            std::cerr << "Ignoring invalid or outdated input log: " << path << "\n";
+            return false;
+        }
+
+        // A log cut short by a crash simply ends at its last whole record
+        records.resize((file.size() - sizeof(header) - header.stateSize) / sizeof(InputRecord));
+        std::memcpy(records.data(), file.data() + sizeof(header) + header.stateSize, records.size() * sizeof(InputRecord));
+        cursor = 0;
+        frames = 0;
+        for (const InputRecord &record : records)
+            frames += record.type == InputRecord::Frame;
+        return true;
+    }
+
+    const SaveState &getInitialState() const { return initial; }
+    size_t getFrameCount() const { return frames; }
+
+    /**
+     * Move to the next frame, skipping any events of the current one
+     * Returns false once the log is exhausted
+     */
+    bool nextFrame(float &time)
+    {
+        while (cursor < records.size() && records[cursor].type != InputRecord::Frame)
+            cursor++;
+        if (cursor == records.size())
+            return false;
+        time = records[cursor++].value;
+        return true;
+    }
+
+    /**
+     * Next event of the current frame
+     * Returns false when the frame has no more events
+     */
+    bool nextEvent(sf::Event &event)
+    {
+        if (cursor == records.size() || records[cursor].type == InputRecord::Frame)
+            return false;
+        event = decodeEvent(records[cursor++]);
+        return true;
+    }
+};
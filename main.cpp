@@ -2,146 +2,269 @@
 #include <vector>
 #include <string>
 #include <map>
+#include <set>
+#include <string_view>
+#include <memory_resource>
 #include <memory>
 #include <algorithm>
 #include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <fstream>
+#include "simulation.hpp"
+#include "profiler.hpp"
+#include "asset_archive.hpp"
+#include "image_loader.hpp"
+#include "resources.hpp"
+#include "recipe_explorer.hpp"
+#include "frame_arena.hpp"
+#include "input_log.hpp"
+#include "sprite_batch.hpp"
+#include "file_watcher.hpp"
+#include "particles.hpp"
 
 /*
 Compilation instructions:
-g++ -c main.cpp -o main.o -std=c++17
-g++ main.o -o game -lsfml-graphics -lsfml-window -lsfml-system
+g++ -c allocation_counter.cpp -o allocation_counter.o -std=c++17 -O2
+g++ -c main.cpp -o main.o -std=c++17 -pthread
+g++ main.o allocation_counter.o -o game -lsfml-graphics -lsfml-window -lsfml-system -pthread
 */
 
 /**
- * Element class represents discoverable elements in the game
- * Each element has a name, description, discovery status, and creation count
+ * TextureAtlas packs many small images into a few large texture pages
+ * Everything drawn from the same page can share a single draw call
  */
-class Element
+class TextureAtlas
 {
 public:
-    std::string name;        // Element name (e.g., "Fire", "Air")
-    std::string description; // Descriptive text for the element
-    bool discovered;         // Whether the player has discovered this element
-    int creationCount;       // How many times this element has been created
+    using Region = AtlasRegion;
 
-    Element(const std::string &n, const std::string &desc, bool disc = false)
-        : name(n), description(desc), discovered(disc), creationCount(0) {}
-};
-
-/**
- * GameObject class represents interactive element instances in the game world
- * These are the draggable sprites that players can combine
- */
-class GameObject
-{
-public:
-    std::shared_ptr<Element> element; // Reference to the element type
-    sf::Sprite sprite;                // Visual representation
-    std::string spritePath;           // Path to the sprite image file
-    float creationTime;               // When this object was created (for cleanup)
-    bool isDragging;                  // Whether this object is currently being dragged
-
-    GameObject(std::shared_ptr<Element> elem, const sf::Texture &texture, const std::string &path, sf::Vector2f pos, float time)
-        : element(elem), spritePath(path), creationTime(time), isDragging(false)
+private:
+    /**
+     * Image queued for the next build(); reserved entries have a size but no pixels yet
+     */
+    struct PendingImage
     {
-        sprite.setTexture(texture);
-        sprite.setPosition(pos);
-        sprite.setScale(0.5f, 0.5f); // Scale down sprites to 50% size
-    }
-};
+        std::string key;
+        sf::Image image;
+        sf::Vector2u size;
+    };
 
-/**
- * CombinationRegistry manages valid element combinations and their results
- * Stores recipes for creating new elements from existing ones
- */
-class CombinationRegistry
-{
-    // Map storing element pairs and their combination results
-    std::map<std::pair<std::string, std::string>, std::string> combinations;
+    std::vector<std::unique_ptr<sf::Texture>> pages;    // Packed page textures (stable addresses)
+    std::map<std::string, Region, std::less<>> regions; // Packed regions mapped by key (found without building a string)
+    std::vector<PendingImage> pending;                  // Images queued for the next build()
+    const unsigned padding = 2;                         // Gap between packed images to avoid bleeding
 
 public:
-    CombinationRegistry()
+    /**
+     * Queue an image to be packed under the given key (element name or asset path)
+     */
+    void add(const std::string &key, const sf::Image &image)
     {
-        // Basic Element Combinations (6 combinations)
-        combinations[{"Fire", "Water"}] = "Steam";
-        combinations[{"Water", "Fire"}] = "Steam";
+        pending.push_back({key, image, image.getSize()});
+    }
 
-        combinations[{"Fire", "Earth"}] = "Lava";
-        combinations[{"Earth", "Fire"}] = "Lava";
+    /**
+     * Render a line of text once and queue it as an image
+     * The image keeps the text's offset from its origin, so a quad drawn at a
+     * position looks like an sf::Text placed there
+     */
+    void addText(const std::string &key, const sf::String &string, const sf::Font &font, unsigned characterSize, sf::Color color)
+    {
+        sf::Text text(string, font, characterSize);
+        text.setFillColor(color);
+        sf::FloatRect bounds = text.getLocalBounds();
+
+        sf::RenderTexture canvas;
+        unsigned width = std::max(1u, static_cast<unsigned>(std::ceil(bounds.left + bounds.width)));
+        unsigned height = std::max(1u, static_cast<unsigned>(std::ceil(bounds.top + bounds.height)));
+        if (!canvas.create(width, height))
+        {
+            std::cerr << "Failed to render label: " << key << "\n";
+            return;
+        }
+        canvas.clear(sf::Color::Transparent);
+        canvas.draw(text);
+        canvas.display();
+        add(key, canvas.getTexture().copyToImage());
+    }
 
-        combinations[{"Fire", "Air"}] = "Smoke";
-        combinations[{"Air", "Fire"}] = "Smoke";
+    /**
+     * Reserve space for an image that will be uploaded later with update()
+     * The region stays transparent until then
+     */
+    void reserve(const std::string &key, sf::Vector2u size)
+    {
+        pending.push_back({key, sf::Image(), size});
+    }
 
-        combinations[{"Water", "Earth"}] = "Mud";
-        combinations[{"Earth", "Water"}] = "Mud";
+    /**
+     * Upload pixels into a region packed by build() (the image must match the region size)
+     * Returns false if there is no such region or the size differs
+     */
+    bool update(const std::string &key, const sf::Image &image)
+    {
+        auto it = regions.find(key);
+        if (it == regions.end())
+            return false;
 
-        combinations[{"Water", "Air"}] = "Mist";
-        combinations[{"Air", "Water"}] = "Mist";
+        const Region &region = it->second;
+        if (image.getSize() != sf::Vector2u(region.rect.width, region.rect.height))
+            return false;
 
-        combinations[{"Earth", "Air"}] = "Dust";
-        combinations[{"Air", "Earth"}] = "Dust";
+        for (auto &page : pages)
+        {
+            if (page.get() == region.page)
+            {
+                page->update(image, region.rect.left, region.rect.top);
+                return true;
+            }
+        }
+        return false;
+    }
 
-        // Duplicate Element Combinations (4 combinations)
-        combinations[{"Fire", "Fire"}] = "Energy";
-        combinations[{"Water", "Water"}] = "Ocean";
-        combinations[{"Earth", "Earth"}] = "Mountain";
-        combinations[{"Air", "Air"}] = "Wind";
+    /**
+     * Forget the region of a key (and any image queued for it)
+     * Pointers to its region become invalid; the space is freed by the next build()
+     */
+    void remove(const std::string &key)
+    {
+        regions.erase(key);
+        pending.erase(std::remove_if(pending.begin(), pending.end(), [&](const PendingImage &image)
+                                     { return image.key == key; }),
+                      pending.end());
+    }
 
-        // Advanced Combinations (12 combinations)
-        combinations[{"Steam", "Air"}] = "Cloud";
-        combinations[{"Air", "Steam"}] = "Cloud";
+    /**
+     * Pack all queued images into pages using shelf packing and upload each page once
+     * Regions packed before are read back and packed again with them, so replaced and
+     * removed images leave no unused space behind and stale pages are released.
+     * Region pointers stay valid (only their page and rectangle change).
+     */
+    void build()
+    {
+        const unsigned pageSize = std::min(sf::Texture::getMaximumSize(), 4096u);
 
-        combinations[{"Cloud", "Water"}] = "Rain";
-        combinations[{"Water", "Cloud"}] = "Rain";
+        // The last image queued under a key replaces the earlier ones and the packed region
+        std::vector<PendingImage> images;
+        std::set<std::string, std::less<>> queued; // Keys in images
+        for (auto it = pending.rbegin(); it != pending.rend(); ++it)
+        {
+            if (queued.count(it->key))
+                continue;
+            if (it->size.x + 2 * padding > pageSize || it->size.y + 2 * padding > pageSize)
+            {
+                std::cerr << "Image too large for texture atlas: " << it->key << "\n";
+                continue;
+            }
+            queued.insert(it->key);
+            images.push_back(std::move(*it));
+        }
+        pending.clear();
 
-        combinations[{"Mud", "Energy"}] = "Plant";
-        combinations[{"Energy", "Mud"}] = "Plant";
+        // Download each old page once and cut out the regions that are kept
+        std::vector<sf::Image> oldPages;
+        for (const auto &page : pages)
+            oldPages.push_back(page->copyToImage());
+        for (const auto &entry : regions)
+        {
+            if (queued.count(entry.first))
+                continue;
+            const sf::IntRect &rect = entry.second.rect;
+            size_t page = 0;
+            while (pages[page].get() != entry.second.page)
+                page++;
+            PendingImage kept{entry.first, sf::Image(), sf::Vector2u(rect.width, rect.height)};
+            kept.image.create(rect.width, rect.height, sf::Color::Transparent);
+            kept.image.copy(oldPages[page], 0, 0, rect);
+            images.push_back(std::move(kept));
+        }
+        oldPages.clear();
 
-        combinations[{"Lava", "Air"}] = "Stone";
-        combinations[{"Air", "Lava"}] = "Stone";
+        // Place tallest images first so each shelf wastes as little height as possible
+        std::vector<size_t> order(images.size());
+        for (size_t i = 0; i < order.size(); ++i)
+            order[i] = i;
+        std::sort(order.begin(), order.end(), [&](size_t a, size_t b)
+                  { return images[a].size.y > images[b].size.y; });
 
-        combinations[{"Lava", "Mountain"}] = "Volcano";
-        combinations[{"Mountain", "Lava"}] = "Volcano";
+        struct Placement
+        {
+            size_t image;
+            size_t page;
+            sf::IntRect rect;
+        };
+        std::vector<Placement> placements;
+        std::vector<sf::Vector2u> pageExtents(1, sf::Vector2u(0, 0)); // Used width/height of each page
+        unsigned x = padding, y = padding, shelfHeight = 0;
 
-        combinations[{"Energy", "Air"}] = "Lightning";
-        combinations[{"Air", "Energy"}] = "Lightning";
+        for (size_t index : order)
+        {
+            sf::Vector2u size = images[index].size;
 
-        combinations[{"Water", "Wind"}] = "Ice";
-        combinations[{"Wind", "Water"}] = "Ice";
+            // Start a new shelf when the current one is full, and a new page when out of shelves
+            if (x + size.x + padding > pageSize)
+            {
+                x = padding;
+                y += shelfHeight + padding;
+                shelfHeight = 0;
+            }
+            if (y + size.y + padding > pageSize)
+            {
+                pageExtents.emplace_back(0, 0);
+                x = padding;
+                y = padding;
+                shelfHeight = 0;
+            }
 
-        combinations[{"Stone", "Wind"}] = "Sand";
-        combinations[{"Wind", "Stone"}] = "Sand";
+            placements.push_back({index, pageExtents.size() - 1, sf::IntRect(x, y, size.x, size.y)});
+            sf::Vector2u &extent = pageExtents.back();
+            extent.x = std::max(extent.x, x + size.x + padding);
+            extent.y = std::max(extent.y, y + size.y + padding);
+            x += size.x + padding;
+            shelfHeight = std::max(shelfHeight, size.y);
+        }
 
-        combinations[{"Mud", "Plant"}] = "Swamp";
-        combinations[{"Plant", "Mud"}] = "Swamp";
+        // Compose each page on the CPU and upload it to the GPU in one go
+        std::vector<std::unique_ptr<sf::Texture>> newPages(pageExtents.size());
+        for (size_t p = 0; p < pageExtents.size(); ++p)
+        {
+            if (pageExtents[p].x == 0)
+                continue;
 
-        combinations[{"Plant", "Plant"}] = "Forest";
+            sf::Image pageImage;
+            pageImage.create(pageExtents[p].x, pageExtents[p].y, sf::Color::Transparent);
+            for (const auto &placement : placements)
+            {
+                const sf::Image &image = images[placement.image].image;
+                if (placement.page == p && image.getSize().x > 0)
+                    pageImage.copy(image, placement.rect.left, placement.rect.top);
+            }
 
-        combinations[{"Sand", "Sand"}] = "Desert";
+            newPages[p] = std::make_unique<sf::Texture>();
+            newPages[p]->loadFromImage(pageImage);
+        }
 
-        combinations[{"Energy", "Plant"}] = "Life";
-        combinations[{"Plant", "Energy"}] = "Life";
+        for (const auto &placement : placements)
+        {
+            regions[images[placement.image].key] = {newPages[placement.page].get(), placement.rect};
+        }
+        newPages.erase(std::remove(newPages.begin(), newPages.end(), nullptr), newPages.end());
+        pages = std::move(newPages); // Releases the old pages, which no region points at any more
     }
 
     /**
-     * Check if two elements can be combined together
+     * Find the packed region for a key
+     * Returns nullptr if no image was packed under that key
      */
-    bool isValidCombination(const std::string &e1, const std::string &e2) const
+    const Region *find(std::string_view key) const
     {
-        return combinations.find({e1, e2}) != combinations.end();
+        auto it = regions.find(key);
+        return it != regions.end() ? &it->second : nullptr;
     }
 
-    /**
-     * Get the result of combining two elements
-     * Returns empty string if combination is invalid
-     */
-    std::string getResult(const std::string &e1, const std::string &e2) const
-    {
-        auto it = combinations.find({e1, e2});
-        if (it != combinations.end())
-            return it->second;
-        return "";
-    }
+    size_t getPageCount() const { return pages.size(); }
 };
 
 /**
@@ -150,66 +273,116 @@ public:
  */
 class ElementBook
 {
-    std::vector<std::shared_ptr<Element>> elements;     // List of all elements
-    sf::Font font;                                      // Font for text rendering
-    const std::map<std::string, sf::Texture> &textures; // Reference to game textures
-    bool isOpen;                                        // Whether the book is currently open
-    int selectedIndex;                                  // Currently selected element index
-    sf::Texture crossTex;                               // Close button texture
-    sf::Texture bookTex;                                // Book icon texture
-    sf::Sprite bookIcon;                                // Clickable book icon sprite
-    sf::Text welcomeText;                               // Welcome message when no element selected
-    float bookScroll = 0.0f;                            // Scroll offset for book sidebar
-    const float bookScrollSpeed = 30.0f;                // Pixels per scroll step
+    std::vector<std::shared_ptr<Element>> elements;             // List of all elements
+    const sf::Font &font;                                       // Font for text rendering (owned by the resource manager)
+    const TextureAtlas &atlas;                                  // Reference to the game texture atlas
+    const CombinationRegistry &registry;                        // Recipes, for the formulas of each element
+    const AssetArchive *archive;                                // Archive the preview image is read from first (null for loose files)
+    bool isOpen;                                                // Whether the book is currently open
+    int selectedIndex;                                          // Currently selected element index
+    const sf::FloatRect iconBounds{10, 10, 64, 64};             // Clickable book icon area (top-left corner, 64x64)
+    sf::Text welcomeText;                                       // Welcome message when no element selected
+    VirtualList rows{{{130, 100, 100, 380}, 110, 30, 400, 50}}; // Sidebar element list (rows at y = 110 + i * 30)
+    const float bookScrollSpeed = 30.0f;                        // Pixels per scroll step
+
+    // Everything below is built once (or when the shown element changes) and reused every frame
+    sf::RectangleShape sidebarPanel;                            // Left sidebar (element list) background
+    sf::RectangleShape detailsPanel;                            // Main book area background
+    sf::RectangleShape detailsBorder;                           // Border around the details text
+    SpriteBatch iconBatch;                                      // Close button, element icons and row labels, one draw call per atlas page
+    std::vector<const TextureAtlas::Region *> labelRegions;     // Pre-rendered name label of each element
+    std::vector<const TextureAtlas::Region *> iconRegions;      // Row-sized icon of each element
+    std::vector<const TextureAtlas::Region *> spriteRegions;    // Sandbox-sized sprite of each element (preview stand-in)
+    sf::Texture preview;                                        // Full-resolution image of the selected element, only while shown
+    int previewIndex = -1;                                      // Element the preview texture holds
+    bool previewLoaded = false;                                 // Whether the preview texture holds an image
+    sf::Text details;                                           // Details text of the selected element
+    int detailsIndex = -1;                                      // Element the details text was built for
+    bool detailsDiscovered = false;                             // Discovery state the details text was built for
+    int detailsCreationCount = -1;                              // Creation count the details text was built for
+    const size_t maxFormulasShown = 3;                          // Formulas listed before "(+N more)"
 
 public:
-    ElementBook(const std::map<std::string, sf::Texture> &tex) : textures(tex), isOpen(false), selectedIndex(-1)
-    {
-        // Load font for text rendering
-        if (!font.loadFromFile("fonts/Pixel Game.otf"))
-        {
-            std::cerr << "Failed to load font from fonts/Pixel Game.otf, using fallback fonts/arial.ttf\n";
-            font.loadFromFile("fonts/arial.ttf");
-        }
-
-        // Load close button texture (X icon)
-        if (!crossTex.loadFromFile("assets/cross.png"))
-        {
-            std::cerr << "Failed to load close icon: assets/cross.png\n";
-            // Create fallback black square if texture fails to load
-            sf::Image img;
-            img.create(32, 32, sf::Color::Black);
-            crossTex.loadFromImage(img);
-        }
+    /**
+     * Atlas keys for the book's own icons (packed by Game together with the element textures)
+     * The placeholder is a plain white silhouette shared by every undiscovered element
+     */
+    static constexpr const char *crossIconKey = "assets/cross.png";
+    static constexpr const char *bookIconKey = "assets/book.png";
+    static constexpr const char *placeholderKey = "book:placeholder";
 
-        // Load book icon texture
-        if (!bookTex.loadFromFile("assets/book.png"))
-        {
-            std::cerr << "Failed to load book icon: assets/book.png\n";
-            // Create fallback green square if texture fails to load
-            sf::Image img;
-            img.create(30, 30, sf::Color::Green);
-            bookTex.loadFromImage(img);
-        }
+    /**
+     * Atlas keys of the pre-rendered row labels (see TextureAtlas::addText)
+     * Undiscovered elements all share the "???" label
+     */
+    static constexpr const char *unknownLabelKey = "label:???";
+    static std::string labelKey(const std::string &name) { return "label:" + name; }
 
-        // Setup book icon sprite
-        bookIcon.setTexture(bookTex);
-        bookIcon.setPosition(10, 10);                                                // Top-left corner position
-        bookIcon.setScale(64.0f / bookTex.getSize().x, 64.0f / bookTex.getSize().y); // Scale to 64x64 pixels
+    /**
+     * Atlas key of an element's row icon, a copy scaled down to iconSize
+     * (the element's own name keys its sandbox sprite)
+     */
+    static constexpr unsigned iconSize = 20;
+    static std::string iconKey(const std::string &name) { return "icon:" + name; }
 
+    ElementBook(const TextureAtlas &atl, const CombinationRegistry &reg, const sf::Font &fnt, const AssetArchive *assets = nullptr)
+        : font(fnt), atlas(atl), registry(reg), archive(assets), isOpen(false), selectedIndex(-1)
+    {
         // Initialize welcome text displayed when no element is selected
         welcomeText.setFont(font);
         welcomeText.setCharacterSize(22);
         welcomeText.setFillColor(sf::Color::Black);
         welcomeText.setString("Click on the icons to view elements descriptions");
+        welcomeText.setPosition(450, 300); // Centered in book area
+        sf::FloatRect textRect = welcomeText.getLocalBounds();
+        welcomeText.setOrigin(textRect.left + textRect.width / 2.0f, textRect.top + textRect.height / 2.0f);
+
+        // Build the fixed book chrome once
+        sidebarPanel.setSize(sf::Vector2f(100, 400));
+        sidebarPanel.setPosition(100, 100);
+        sidebarPanel.setFillColor(sf::Color(251, 251, 251));
+
+        detailsPanel.setSize(sf::Vector2f(500, 400));
+        detailsPanel.setPosition(200, 100);
+        detailsPanel.setFillColor(sf::Color(217, 234, 242));
+
+        detailsBorder.setSize(sf::Vector2f(300, 125));
+        detailsBorder.setPosition(300, 350);
+        detailsBorder.setFillColor(sf::Color::Transparent);
+        detailsBorder.setOutlineColor(sf::Color::Black);
+        detailsBorder.setOutlineThickness(2);
+
+        details.setFont(font);
+        details.setCharacterSize(18);
+        details.setFillColor(sf::Color::Black);
+        details.setPosition(325, 370);
     }
 
     /**
-     * Add an element to the book's registry
+     * Add an element to the book's registry (after the atlas holding its label is built)
      */
     void addElement(std::shared_ptr<Element> elem)
     {
+        labelRegions.push_back(atlas.find(labelKey(elem->name)));
+        iconRegions.push_back(atlas.find(iconKey(elem->name)));
+        spriteRegions.push_back(atlas.find(elem->name));
         elements.push_back(elem);
+        rows.setCount(elements.size());
+    }
+
+    /**
+     * Remove every element, e.g. before adding them again under new ids
+     */
+    void clearElements()
+    {
+        elements.clear();
+        labelRegions.clear();
+        iconRegions.clear();
+        spriteRegions.clear();
+        rows.setCount(0);
+        selectedIndex = -1;
+        detailsIndex = -1;
+        updatePreview();
     }
 
     /**
@@ -219,14 +392,15 @@ public:
     {
         isOpen = !isOpen;
         selectedIndex = -1; // Clear selection when toggling
+        updatePreview();
     }
 
     bool isBookOpen() const { return isOpen; }
 
     /**
-     * Provide access to the cross texture for other classes
+     * Screen area of the book icon; Game draws it as part of its sprite batch
      */
-    const sf::Texture &getCrossTexture() const { return crossTex; }
+    const sf::FloatRect &getIconBounds() const { return iconBounds; }
 
     /**
      * Handle mouse input for book interactions
@@ -239,7 +413,7 @@ public:
             if (event.type == sf::Event::MouseButtonPressed && event.mouseButton.button == sf::Mouse::Left)
             {
                 sf::Vector2f mousePos = window.mapPixelToCoords(sf::Vector2i(event.mouseButton.x, event.mouseButton.y));
-                if (bookIcon.getGlobalBounds().contains(mousePos))
+                if (iconBounds.contains(mousePos))
                 {
                     toggle();
                 }
@@ -260,27 +434,19 @@ public:
             }
 
             // Handle close button (X) click
-            sf::RectangleShape exitButton(sf::Vector2f(32, 32));
-            exitButton.setPosition(668, 100); // Top-right corner of book
-            if (exitButton.getGlobalBounds().contains(mousePos))
+            const sf::FloatRect exitButton(668, 100, 32, 32); // Top-right corner of book
+            if (exitButton.contains(mousePos))
             {
                 toggle();
                 return;
             }
 
             // Handle element selection in the sidebar
-            for (size_t i = 0; i < elements.size(); ++i)
+            long row = rows.rowAt(mousePos);
+            if (row >= 0)
             {
-                float yPos = 100 + i * 30 - bookScroll;
-                sf::RectangleShape clickArea(sf::Vector2f(100, 30));
-                clickArea.setPosition(130, yPos);
-
-                // Only check if visible
-                if (yPos >= 70 && yPos <= 500 && clickArea.getGlobalBounds().contains(mousePos))
-                {
-                    selectedIndex = static_cast<int>(i);
-                    return;
-                }
+                selectedIndex = static_cast<int>(row);
+                return;
             }
         }
 
@@ -292,238 +458,129 @@ public:
             // Check if mouse is over book sidebar
             if (mousePos.x >= 100 && mousePos.x <= 200 && mousePos.y >= 100 && mousePos.y <= 500)
             {
-                bookScroll -= event.mouseWheelScroll.delta * bookScrollSpeed;
-
-                // Clamp scroll bounds
-                float maxScroll = std::max(0.0f, elements.size() * 30.0f - 400 + 50);
-                bookScroll = std::max(0.0f, std::min(bookScroll, maxScroll));
+                rows.scrollBy(-event.mouseWheelScroll.delta * bookScrollSpeed);
             }
         }
     }
 
     /**
-     * Render the book interface
+     * Render the book interface (the closed-book icon is batched by Game)
+     * Draw calls are counted by the profiler
      */
-    void draw(sf::RenderWindow &window, float time)
+    void draw(sf::RenderWindow &window, float time, FrameProfiler &profiler)
     {
-        // Always draw the book icon
-        window.draw(bookIcon);
-
         // Only draw book contents if open
         if (!isOpen)
             return;
 
-        // Draw left sidebar (element list)
-        sf::RectangleShape sidebar(sf::Vector2f(100, 400));
-        sidebar.setPosition(100, 100);
-        sidebar.setFillColor(sf::Color(251, 251, 251));
-        window.draw(sidebar);
+        // Draw the sidebar (element list) and main book area backgrounds
+        profiler.draw(window, sidebarPanel);
+        profiler.draw(window, detailsPanel);
+
+        // Queue close button (X)
+        iconBatch.clear();
+        if (const TextureAtlas::Region *cross = atlas.find(crossIconKey))
+            iconBatch.add(*cross, sf::FloatRect(668, 100, 32, 32));
+
+        // Queue icons and labels of the visible rows only
+        const TextureAtlas::Region *placeholder = atlas.find(placeholderKey);
+        const TextureAtlas::Region *unknownLabel = atlas.find(unknownLabelKey);
+        queueElementRows(iconBatch, rows, 105, iconSize,
+                         [&](size_t i, const TextureAtlas::Region *&icon, const TextureAtlas::Region *&label)
+                         {
+                             bool discovered = elements[i]->discovered;
+                             icon = discovered ? iconRegions[i] : placeholder;
+                             label = discovered ? labelRegions[i] : unknownLabel;
+                         });
 
-        // Draw main book area (element details)
-        sf::RectangleShape bg(sf::Vector2f(500, 400));
-        bg.setPosition(200, 100);
-        bg.setFillColor(sf::Color(217, 234, 242));
-        window.draw(bg);
-
-        // Draw close button (X)
-        sf::Sprite closeIcon(crossTex);
-        closeIcon.setPosition(668, 100);
-        closeIcon.setScale(32.0f / crossTex.getSize().x, 32.0f / crossTex.getSize().y);
-        window.draw(closeIcon);
+        // Draw selected element details in main area
+        if (selectedIndex >= 0 && selectedIndex < static_cast<int>(elements.size()))
+        {
+            auto elem = elements[selectedIndex];
 
-        // Draw element list in sidebar with scrolling
-        for (size_t i = 0; i < elements.size(); ++i)
+            // Queue large element icon, from the full-size image when it loaded
+            const sf::FloatRect previewBounds(350, 125, 200, 200); // Centered in book area
+            updatePreview();
+            if (previewLoaded)
+                iconBatch.add(preview, sf::IntRect(0, 0, preview.getSize().x, preview.getSize().y), previewBounds);
+            else if (const TextureAtlas::Region *region = elem->discovered ? spriteRegions[selectedIndex] : placeholder)
+                iconBatch.add(*region, previewBounds);
+
+            updateDetails();
+            profiler.draw(window, detailsBorder);
+            profiler.draw(window, details);
+        }
+        else
         {
-            float yPos = 110 + i * 30 - bookScroll;
+            // Show welcome text when no element is selected
+            profiler.draw(window, welcomeText);
+        }
 
-            // Only draw if visible
-            if (yPos >= 100 && yPos <= 480)
-            {
-                sf::Sprite icon;
-                if (elements[i]->discovered)
-                {
-                    auto it = textures.find(elements[i]->name);
-                    if (it != textures.end())
-                    {
-                        icon.setTexture(it->second);
-                        icon.setScale(20.0f / it->second.getSize().x, 20.0f / it->second.getSize().y);
-                    }
-                }
-                else
-                {
-                    sf::Texture placeholder;
-                    sf::Image img;
-                    img.create(20, 20, sf::Color::White);
-                    placeholder.loadFromImage(img);
-                    icon.setTexture(placeholder);
-                    icon.setScale(1.0f, 1.0f);
-                }
-                icon.setPosition(105, yPos);
-                window.draw(icon);
+        // Draw every queued icon and label at once (they never overlap the text)
+        profiler.countDrawCalls(iconBatch.draw(window));
+    }
 
-                sf::Text text(elements[i]->discovered ? elements[i]->name : "???", font, 20);
-                text.setPosition(130, yPos);
-                text.setFillColor(sf::Color::Black);
-                window.draw(text);
-            }
-        }
+private:
+    /**
+     * Load the selected element's full-size image, or free it when nothing discovered is selected
+     * Only the book preview draws at this size, so the image lives outside the atlas
+     */
+    void updatePreview()
+    {
+        bool wanted = isOpen && selectedIndex >= 0 && elements[selectedIndex]->discovered;
+        int index = wanted ? selectedIndex : -1;
+        if (index == previewIndex)
+            return;
 
-        // Draw selected element details in main area
-        if (selectedIndex >= 0 && selectedIndex < static_cast<int>(elements.size()))
+        previewIndex = index;
+        preview = sf::Texture(); // Release the previous image's video memory
+        previewLoaded = wanted && loadAsset(archive, elements[index]->texture, preview);
+        if (previewLoaded)
         {
-            auto elem = elements[selectedIndex];
+            preview.setSmooth(true); // Drawn scaled to the preview box
+        }
+    }
 
-            // Draw large element icon
-            sf::Sprite largeIcon;
-            if (elem->discovered)
-            {
-                auto it = textures.find(elem->name);
-                if (it != textures.end())
-                {
-                    largeIcon.setTexture(it->second);
-                    largeIcon.setScale(200.0f / it->second.getSize().x, 200.0f / it->second.getSize().y);
-                }
-            }
-            else
-            {
-                // Show large placeholder for undiscovered elements
-                sf::Texture placeholder;
-                sf::Image img;
-                img.create(200, 200, sf::Color::White);
-                placeholder.loadFromImage(img);
-                largeIcon.setTexture(placeholder);
-                largeIcon.setScale(1.0f, 1.0f);
-            }
-            largeIcon.setPosition(350, 125); // Centered in book area
-            window.draw(largeIcon);
-
-            // Draw element details text
-            sf::Text details;
-            details.setFont(font);
-            details.setCharacterSize(18);
-            details.setFillColor(sf::Color::Black);
-            if (elem->discovered)
+    /**
+     * Rebuild the details text when the selected element or its state changed
+     */
+    void updateDetails()
+    {
+        auto elem = elements[selectedIndex];
+        if (detailsIndex == selectedIndex && detailsDiscovered == elem->discovered &&
+            detailsCreationCount == elem->creationCount)
+            return;
+        detailsIndex = selectedIndex;
+        detailsDiscovered = elem->discovered;
+        detailsCreationCount = elem->creationCount;
+
+        if (elem->discovered)
+        {
+            // Every known formula, straight from the registry's reverse index
+            std::string formula;
+            CombinationRegistry::FormulaRange range = registry.getFormulas(elem->id);
+            size_t shown = 0;
+            for (const CombinationRegistry::Formula &f : range)
             {
-                std::string formula;
-                if (elem->name == "Steam")
-                {
-                    formula = "Fire + Water";
-                }
-                else if (elem->name == "Lava")
-                {
-                    formula = "Fire + Earth";
-                }
-                else if (elem->name == "Smoke")
-                {
-                    formula = "Fire + Air";
-                }
-                else if (elem->name == "Mud")
-                {
-                    formula = "Water + Earth";
-                }
-                else if (elem->name == "Mist")
-                {
-                    formula = "Water + Air";
-                }
-                else if (elem->name == "Dust")
-                {
-                    formula = "Earth + Air";
-                }
-                else if (elem->name == "Energy")
-                {
-                    formula = "Fire + Fire";
-                }
-                else if (elem->name == "Ocean")
-                {
-                    formula = "Water + Water";
-                }
-                else if (elem->name == "Mountain")
-                {
-                    formula = "Earth + Earth";
-                }
-                else if (elem->name == "Wind")
-                {
-                    formula = "Air + Air";
-                }
-                else if (elem->name == "Cloud")
-                {
-                    formula = "Steam + Air";
-                }
-                else if (elem->name == "Rain")
-                {
-                    formula = "Cloud + Water";
-                }
-                else if (elem->name == "Plant")
-                {
-                    formula = "Mud + Energy";
-                }
-                else if (elem->name == "Stone")
-                {
-                    formula = "Lava + Air";
-                }
-                else if (elem->name == "Volcano")
-                {
-                    formula = "Lava + Mountain";
-                }
-                else if (elem->name == "Lightning")
-                {
-                    formula = "Energy + Air";
-                }
-                else if (elem->name == "Ice")
-                {
-                    formula = "Water + Wind";
-                }
-                else if (elem->name == "Sand")
-                {
-                    formula = "Stone + Wind";
-                }
-                else if (elem->name == "Swamp")
-                {
-                    formula = "Mud + Plant";
-                }
-                else if (elem->name == "Forest")
-                {
-                    formula = "Plant + Plant";
-                }
-                else if (elem->name == "Desert")
-                {
-                    formula = "Sand + Sand";
-                }
-                else if (elem->name == "Life")
-                {
-                    formula = "Energy + Plant";
-                }
-                else
+                if (shown == maxFormulasShown)
                 {
-                    formula = "Basic Element";
+                    formula += " (+" + std::to_string(range.size() - shown) + " more)";
+                    break;
                 }
-                // Show full details for discovered elements
-                details.setString("Name: " + elem->name + "\nCreated: " + std::to_string(elem->creationCount) +
-                                  "\nDescription: " + elem->description + "\nFormula: " + formula);
-            }
-            else
-            {
-                // Show hidden details for undiscovered elements
-                details.setString("Name: ???\nCreated: ???\nDescription: ???\nFormula: ???");
+                formula += shown++ ? " / " : "";
+                for (std::uint16_t k = 0; k < f.count; ++k)
+                    formula += (k ? " + " : "") + elements[f.ingredients[k]]->name;
             }
-            details.setPosition(325, 370);
-
-            // Draw border around details area
-            sf::RectangleShape border(sf::Vector2f(300, 125));
-            border.setPosition(300, 350);
-            border.setFillColor(sf::Color::Transparent);
-            border.setOutlineColor(sf::Color::Black);
-            border.setOutlineThickness(2);
-            window.draw(border);
-            window.draw(details);
+            if (range.empty())
+                formula = "Basic Element";
+            // Show full details for discovered elements
+            details.setString("Name: " + elem->name + "\nCreated: " + std::to_string(elem->creationCount) +
+                              "\nDescription: " + elem->description + "\nFormula: " + formula);
         }
         else
         {
-            // Show welcome text when no element is selected
-            welcomeText.setPosition(450, 300); // Centered in book area
-            sf::FloatRect textRect = welcomeText.getLocalBounds();
-            welcomeText.setOrigin(textRect.left + textRect.width / 2.0f, textRect.top + textRect.height / 2.0f);
-            window.draw(welcomeText);
+            // Show hidden details for undiscovered elements
+            details.setString("Name: ???\nCreated: ???\nDescription: ???\nFormula: ???");
         }
     }
 };
@@ -533,466 +590,1184 @@ public:
  */
 class Game
 {
-    sf::RenderWindow window;                          // Main game window
-    std::vector<std::shared_ptr<Element>> elements;   // All available elements
-    std::vector<std::shared_ptr<GameObject>> objects; // Active game objects in the world
-    std::map<std::string, sf::Texture> textures;      // Loaded textures mapped by element name
-    CombinationRegistry registry;                     // Handles element combination logic
-    ElementBook book;                                 // Element encyclopedia
-    sf::Texture trashTex;                             // Trash bin texture
-    sf::Sprite trashBin;                              // Trash bin sprite for deleting objects
-    std::shared_ptr<GameObject> draggingObject;       // Currently dragged object (if any)
-    sf::Sprite invalidMark;                           // Red X shown for invalid combinations
-    float invalidMarkTime;                            // When to stop showing invalid mark
-    sf::Vector2f invalidMarkPos;                      // Position of invalid mark
-    sf::Font font;                                    // Font for UI text
-    sf::Clock clock;                                  // Game timer
-    const int maxObjects = 50;                        // Maximum objects allowed in world
-    float sidebarScroll = 0.0f;                       // Scroll offset for right sidebar
-    const float scrollSpeed = 30.0f;                  // Pixels per scroll step
+    sf::RenderWindow window;                                      // Main game window
+    AssetArchive archive;                                         // Packed images and fonts, read before loose files (not open in development)
+    ResourceManager resources;                                    // Fonts and images, loaded once per path
+    const sf::Font &font;                                         // Font for UI text (shared with the book and profiler)
+    Simulation sim;                                               // Elements, objects, recipes and discovery state
+    TextureAtlas atlas;                                           // All element and UI icons packed into shared pages
+    std::vector<const TextureAtlas::Region *> elementRegions;     // Atlas region of each element's sandbox sprite, by id
+    std::vector<const TextureAtlas::Region *> iconRegions;        // Atlas region of each element's sidebar icon, by id
+    std::vector<const TextureAtlas::Region *> labelRegions;       // Atlas region of each element's name label, by id
+    SpriteBatch batch;                                            // Per-frame batch of the UI quads (sidebar, trash, book icon)
+    SpriteBatch worldBatch;                                       // Per-frame batch of the visible sandbox objects, in world space
+    sf::View camera;                                              // Part of the world shown in the sandbox area (pan and zoom)
+    FrameArena frameArena;                                        // Temporaries of the current frame, reset every frame
+    sf::RectangleShape sandboxPanel;                              // Sandbox background (built once, not every frame)
+    sf::RectangleShape sidebarPanel;                              // Right sidebar background
+    bool panning = false;                                         // Right mouse button is dragging the camera
+    bool boxSelecting = false;                                    // Left mouse button is dragging a selection box
+    sf::Vector2f boxStart;                                        // World position where the selection box started
+    sf::Vector2f boxEnd;                                          // World position of the box's moving corner
+    sf::RectangleShape selectionOutline;                          // Outline drawn around the selection box
+    DropPreview hoverPreview;                                     // What dropping the dragged object would do right now
+    std::uint64_t previewRevision = ~0ull;                        // Simulation revision hoverPreview was computed at
+    sf::Vector2i panLast;                                         // Mouse pixel of the last panning step
+    ElementBook book;                                             // Element encyclopedia
+    sf::FloatRect trashBin;                                       // Trash bin area for deleting objects
+    float invalidMarkTime;                                        // When to stop showing invalid mark
+    sf::Vector2f invalidMarkPos;                                  // Position of invalid mark
+    sf::Clock clock;                                              // Game timer
+    VirtualList sidebar{{{705, -30, 100, 630}, 10, 30, 600, 50}}; // Right sidebar of discovered elements (rows at y = 10 + k * 30)
+    const float scrollSpeed = 30.0f;                              // Pixels per scroll step
+    FrameProfiler profiler;                                       // Per-frame timings, draw calls and allocations (F3)
+    ImageLoader loader;                                           // Decodes element images on worker threads
+    std::vector<std::string> deferredTextures;                    // Texture path of each element not loaded yet, by id
+    bool dirty = true;                                            // Input or UI state changed since the last repaint
+    std::uint64_t drawnRevision = ~0ull;                          // Simulation revision shown by the last repaint
+    bool invalidMarkShown = false;                                // Last repaint showed the invalid mark
+    bool continuousRedraw = false;                                // Repaint every frame even when nothing changed
+    const sf::Time idlePollInterval = sf::milliseconds(10);       // Sleep between polls while waiting for a deadline
+    const sf::Time watchPollInterval = sf::milliseconds(50);      // Input poll interval while idle with only the watcher pending
+    AutosaveWorker autosave;                                      // Writes save snapshots off the render thread
+    std::uint64_t savedRevision = ~0ull;                          // Simulation revision of the last save or load
+    float nextAutosave = 0.0f;                                    // Earliest time of the next autosave
+    const float autosaveInterval = 30.0f;                         // Seconds between autosaves while playing
+    InputRecorder recorder;                                       // Writes the session's input to a log (--record)
+    InputReplay replay;                                           // Input log being played back (--replay)
+    bool replaying = false;                                       // Frames and events come from replay instead of the window
+    float replayTime = 0.0f;                                      // Recorded game time of the frame being replayed
+    std::vector<double> replayFrameMs;                            // Time of every replayed frame, for the summary
+    std::string packFile;                                         // Recipe pack the game was loaded from
+    FileWatcher watcher;                                          // Reports edits to the pack and images (--watch)
+    bool watching = false;                                        // Edited files are reloaded while playing
+    ParticleSystem particles;                                     // Combination and discovery bursts, in world space
+    float particleTime = 0.0f;                                    // Game time particles were last advanced to
+    // Effect looks: a white puff for every combination, a bigger golden burst for a discovery
+    const ParticleSystem::Burst combineBurst{48, 220.0f, 0.6f, 6.0f, sf::Color(255, 255, 255, 220)};
+    const ParticleSystem::Burst discoveryBurst{256, 420.0f, 1.2f, 8.0f, sf::Color(255, 215, 64)};
+    RecipeExplorer explorer;                                      // Recipe graph search for hints and pack checks
+    RecipeExplorer::Hint hint;                                    // Cheapest next discovery, kept current after each discovery
+    sf::Text hintText;                                            // Hint shown in the sandbox while toggled on (H)
+    bool hintVisible = false;                                     // Whether the hint is shown
+
+    static constexpr const char *trashIconKey = "assets/trashbin.png"; // Atlas key of the trash bin icon
+    static constexpr const char *uiFontPath = "fonts/Pixel Game.otf";  // Font of every label in the game
+    static constexpr const char *fallbackFontPath = "fonts/arial.ttf"; // Used if the UI font fails to load
+    static constexpr unsigned uiIconSize = 64;                         // Largest size UI icons are drawn at
+    static constexpr float sidebarWidth = 100.0f;                      // Width of the right sidebar in pixels
+    static constexpr float minZoom = 0.25f;                            // Closest camera zoom (world units per pixel)
+    static constexpr float maxZoom = 8.0f;                             // Farthest camera zoom
+    static constexpr float zoomStep = 1.1f;                            // Zoom factor of one scroll step
+    static constexpr float maxParticleStep = 0.1f;                     // Longest particle step (after sleeping while idle)
 
 public:
-    Game() : window(sf::VideoMode(800, 600), "Little Alchemist"), book(textures), invalidMarkTime(0)
+    static constexpr const char *DefaultSavePath = "progress.sav";
+    static constexpr const char *DefaultArchivePath = "assets.pak"; // Built with ./packassets
+
+    /**
+     * archivePath names the packed asset archive to read images and fonts from;
+     * empty (or a missing archive) reads the loose files instead
+     */
+    explicit Game(size_t objectLimit = 50, const std::string &packPath = Simulation::DefaultPackPath,
+                  const std::string &savePath = DefaultSavePath, const std::string &archivePath = "")
+        : window(sf::VideoMode(800, 600), "Little Alchemist"), archive(archivePath), resources(&archive),
+          font(resources.get(resources.loadFont(uiFontPath, fallbackFontPath))),
+          sim(objectLimit, packPath), book(atlas, sim.registry, font, &archive), invalidMarkTime(0), autosave(savePath),
+          packFile(packPath)
     {
         window.setFramerateLimit(60); // Limit to 60 FPS
-
-        // Load font for UI text
-        if (!font.loadFromFile("fonts/Pixel Game.otf"))
-        {
-            std::cerr << "Failed to load font from fonts/Pixel Game.otf, using fallback fonts/arial.ttf\n";
-            font.loadFromFile("fonts/arial.ttf");
-        }
-
-        // Define texture file paths for each element
-        std::map<std::string, std::string> texturePaths = {
-            // Basic Elements
-            {"Fire", "assets/fire.png"},
-            {"Water", "assets/water.png"},
-            {"Earth", "assets/earth.png"},
-            {"Air", "assets/air.png"},
-
-            // Basic Combinations (2 basic elements)
-            {"Steam", "assets/steam.png"}, // Fire + Water
-            {"Lava", "assets/lava.png"},   // Fire + Earth
-            {"Smoke", "assets/smoke.png"}, // Fire + Air
-            {"Mud", "assets/mud.png"},     // Water + Earth
-            {"Mist", "assets/mist.png"},   // Water + Air
-            {"Dust", "assets/dust.png"},   // Earth + Air
-
-            // Duplicate Element Combinations
-            {"Energy", "assets/energy.png"},     // Fire + Fire
-            {"Ocean", "assets/ocean.png"},       // Water + Water
-            {"Mountain", "assets/mountain.png"}, // Earth + Earth
-            {"Wind", "assets/wind.png"},         // Air + Air
-
-            // Advanced Combinations
-            {"Cloud", "assets/cloud.png"},         // Steam + Air
-            {"Rain", "assets/rain.png"},           // Cloud + Water
-            {"Plant", "assets/plant.png"},         // Water + Earth + Energy
-            {"Stone", "assets/stone.png"},         // Lava + Air
-            {"Volcano", "assets/volcano.png"},     // Lava + Mountain
-            {"Lightning", "assets/lightning.png"}, // Energy + Air
-            {"Ice", "assets/ice.png"},             // Water + Wind
-            {"Sand", "assets/sand.png"},           // Stone + Wind
-            {"Swamp", "assets/swamp.png"},         // Mud + Plant
-            {"Forest", "assets/forest.png"},       // Plant + Plant
-            {"Desert", "assets/desert.png"},       // Sand + Sand
-            {"Life", "assets/life.png"}            // Energy + Plant
-        };
-
-        // Load all element textures
-        for (const auto &pair : texturePaths)
+        loader.setArchive(&archive);
+
+        profiler.setFont(font);
+        sidebar.setCount(sim.getDiscovered().size());
+
+        // The camera starts out showing the old fixed sandbox, one world unit per pixel
+        sf::Vector2f windowSize(window.getSize());
+        camera.reset(sf::FloatRect(0, 0, windowSize.x - sidebarWidth, windowSize.y));
+        camera.setViewport(sf::FloatRect(0, 0, (windowSize.x - sidebarWidth) / windowSize.x, 1));
+
+        sandboxPanel.setSize(sf::Vector2f(windowSize.x - sidebarWidth, windowSize.y));
+        sandboxPanel.setFillColor(sf::Color(243, 124, 84)); // Main sandbox color
+        sidebarPanel.setSize(sf::Vector2f(sidebarWidth, windowSize.y));
+        sidebarPanel.setPosition(windowSize.x - sidebarWidth, 0);
+        sidebarPanel.setFillColor(sf::Color(255, 194, 77)); // Light gray
+        selectionOutline.setFillColor(sf::Color(170, 210, 255, 60));
+        selectionOutline.setOutlineColor(sf::Color(40, 90, 200));
+
+        // Decode the images needed right away on worker threads; undiscovered elements
+        // only reserve their atlas space (sizes follow from the PNG header) and load on discovery
+        deferredTextures.resize(sim.elements.size());
+        // Image paths come from the recipe pack
+        for (const auto &elem : sim.elements)
         {
-            sf::Texture tex;
-            if (!tex.loadFromFile(pair.second))
+            std::vector<ImageLoader::Variant> variants = elementVariants(*elem);
+            if (!elem->discovered)
             {
-                std::cerr << "Failed to load texture: " << pair.second << "\n";
-                // Create fallback magenta square if texture loading fails
-                sf::Image img;
-                img.create(50, 50, sf::Color::Magenta);
-                tex.loadFromImage(img);
+                for (const auto &variant : variants)
+                    atlas.reserve(variant.key, variant.size);
+                deferredTextures[elem->id] = elem->texture;
+            }
+            else
+            {
+                loader.request(elem->texture, std::move(variants));
             }
-            textures[pair.first] = tex;
-        }
-
-        // Initialize game elements (4 basic + 22 discoverable = 26 total)
-        // Basic Elements (discovered = true)
-        elements.push_back(std::make_shared<Element>("Fire", "A blazing flame", true));
-        elements.push_back(std::make_shared<Element>("Water", "Crystal clear liquid", true));
-        elements.push_back(std::make_shared<Element>("Earth", "Rich brown soil", true));
-        elements.push_back(std::make_shared<Element>("Air", "Invisible breeze", true));
-
-        // Basic Combinations (discovered = false)
-        elements.push_back(std::make_shared<Element>("Steam", "Hot water vapor", false));
-        elements.push_back(std::make_shared<Element>("Lava", "Molten rock and fire", false));
-        elements.push_back(std::make_shared<Element>("Smoke", "Cloudy haze", false));
-        elements.push_back(std::make_shared<Element>("Mud", "Wet and sticky earth", false));
-        elements.push_back(std::make_shared<Element>("Mist", "Gentle water vapor", false));
-        elements.push_back(std::make_shared<Element>("Dust", "Fine particles in air", false));
-
-        // Duplicate Element Combinations
-        elements.push_back(std::make_shared<Element>("Energy", "Pure concentrated power", false));
-        elements.push_back(std::make_shared<Element>("Ocean", "Vast body of water", false));
-        elements.push_back(std::make_shared<Element>("Mountain", "Towering earthen peak", false));
-        elements.push_back(std::make_shared<Element>("Wind", "Strong moving air", false));
-
-        // Advanced Combinations
-        elements.push_back(std::make_shared<Element>("Cloud", "Fluffy sky formation", false));
-        elements.push_back(std::make_shared<Element>("Rain", "Falling water droplets", false));
-        elements.push_back(std::make_shared<Element>("Plant", "Green growing life", false));
-        elements.push_back(std::make_shared<Element>("Stone", "Hard solid rock", false));
-        elements.push_back(std::make_shared<Element>("Volcano", "Explosive mountain", false));
-        elements.push_back(std::make_shared<Element>("Lightning", "Electric bolt", false));
-        elements.push_back(std::make_shared<Element>("Ice", "Frozen water crystal", false));
-        elements.push_back(std::make_shared<Element>("Sand", "Tiny rock particles", false));
-        elements.push_back(std::make_shared<Element>("Swamp", "Muddy wetland", false));
-        elements.push_back(std::make_shared<Element>("Forest", "Dense tree collection", false));
-        elements.push_back(std::make_shared<Element>("Desert", "Vast sandy wasteland", false));
-        elements.push_back(std::make_shared<Element>("Life", "The essence of living things", false));
-
-        // Add all elements to the book
-        for (auto &elem : elements)
-        {
-            book.addElement(elem);
         }
 
-        // Initialize trash bin sprite
-        if (!trashTex.loadFromFile("assets/trashbin.png"))
+        // Load UI icons into the same atlas (keyed by path so they never clash with element names)
+        const std::map<std::string, sf::Color> uiIcons = {
+            {ElementBook::crossIconKey, sf::Color::Black}, // Close button and invalid mark
+            {ElementBook::bookIconKey, sf::Color::Green},  // Book icon
+            {trashIconKey, sf::Color::Red}                 // Trash bin
+        };
+        // These are few, so they load here while the workers decode element images
+        for (const auto &icon : uiIcons)
         {
-            std::cerr << "Failed to load trash icon: assets/trashbin.png\n";
-            // Create fallback red square if texture loading fails
-            sf::Image img;
-            img.create(30, 30, sf::Color::Red);
-            trashTex.loadFromImage(img);
+            ResourceManager::ImageHandle image = resources.loadImage(icon.first, sf::Vector2u(32, 32), icon.second);
+            atlas.add(icon.first, resizeImage(resources.get(image), sf::Vector2u(uiIconSize, uiIconSize)));
+            resources.release(image); // The atlas keeps its own copy
         }
-        trashBin.setTexture(trashTex);
-        trashBin.setPosition(10, window.getSize().y - 74);                             // Bottom-left corner
-        trashBin.setScale(64.0f / trashTex.getSize().x, 64.0f / trashTex.getSize().y); // Scale to 64x64
-
-        // Initialize invalid combination marker (red X)
-        invalidMark.setTexture(book.getCrossTexture());
-        invalidMark.setScale(24.0f / book.getCrossTexture().getSize().x, 24.0f / book.getCrossTexture().getSize().y);
-        invalidMark.setColor(sf::Color::Red);
-    }
 
-    /**
-     * Main game loop - runs until window is closed
-     */
-    void run()
-    {
-        while (window.isOpen())
+        // Name labels are laid out once here and drawn as atlas quads from then on
+        for (const auto &elem : sim.elements)
         {
-            handleEvents();
-            update(clock.getElapsedTime().asSeconds());
-            draw();
+            atlas.addText(ElementBook::labelKey(elem->name), elem->name, font, 20, sf::Color::Black);
         }
-    }
+        atlas.addText(ElementBook::unknownLabelKey, "???", font, 20, sf::Color::Black);
 
-private:
-    /**
-     * Handle all input events (mouse clicks, window close, etc.)
-     */
-    void handleEvents()
-    {
-        sf::Event event;
-        while (window.pollEvent(event))
+        // Shared silhouette drawn (scaled) for every undiscovered element in the book
+        atlas.add(ElementBook::placeholderKey, resources.get(resources.fallbackImage(sf::Vector2u(4, 4), sf::Color::White)));
+
+        loader.waitIdle();
+        for (auto &loaded : loader.collect())
         {
-            // Handle window close button
-            if (event.type == sf::Event::Closed)
+            if (!loaded.ok)
+                std::cerr << "Failed to load texture: " << loaded.path << "\n";
+            for (size_t i = 0; i < loaded.variants.size(); ++i)
             {
-                window.close();
+                // Use the shared magenta square if texture loading fails
+                const ImageLoader::Variant &variant = loaded.variants[i];
+                atlas.add(variant.key, loaded.ok ? loaded.images[i] : resources.get(resources.fallbackImage(variant.size, sf::Color::Magenta)));
             }
+        }
 
-            // Handle scroll wheel for right sidebar
-            if (event.type == sf::Event::MouseWheelScrolled)
-            {
-                sf::Vector2f mousePos = window.mapPixelToCoords(sf::Vector2i(event.mouseWheelScroll.x, event.mouseWheelScroll.y));
+        // Pack everything and upload it to the GPU in one batch
+        atlas.build();
 
-                // Check if mouse is over right sidebar
-                if (mousePos.x > window.getSize().x - 100 && !book.isBookOpen())
-                {
-                    sidebarScroll -= event.mouseWheelScroll.delta * scrollSpeed;
+        indexElements();
 
-                    // Get count of discovered elements
-                    int discoveredCount = 0;
-                    for (auto &elem : elements)
-                    {
-                        if (elem->discovered)
-                            discoveredCount++;
-                    }
+        // Place trash bin in the bottom-left corner, scaled to 64x64
+        trashBin = sf::FloatRect(10, window.getSize().y - 74.0f, 64, 64);
 
-                    // Clamp scroll bounds
-                    float maxScroll = std::max(0.0f, discoveredCount * 30.0f - window.getSize().y + 50);
-                    sidebarScroll = std::max(0.0f, std::min(sidebarScroll, maxScroll));
-                }
-            }
+        checkPack();
 
-            // Let book handle its input first
-            book.handleInput(event, window);
+        hintText.setFont(font);
+        hintText.setCharacterSize(20);
+        hintText.setFillColor(sf::Color::Black);
+        hintText.setPosition(84, window.getSize().y - 34.0f);
 
-            // Skip game input handling if book is open
-            if (book.isBookOpen())
-            {
-                continue;
-            }
+        // Continue where the last session stopped
+        loadGame();
+        updateHint();
+    }
 
-            // Handle mouse button press
-            if (event.type == sf::Event::MouseButtonPressed && event.mouseButton.button == sf::Mouse::Left)
-            {
-                sf::Vector2f mousePos = window.mapPixelToCoords(sf::Vector2i(event.mouseButton.x, event.mouseButton.y));
+    /**
+     * Change the maximum number of objects in the world
+     * Excess objects are evicted oldest first on the next update
+     */
+    void setMaxObjects(size_t limit) { sim.setMaxObjects(limit); }
 
-                // Check if clicking on element buttons in right sidebar
-                int discoveredIndex = 0;
-                for (size_t i = 0; i < elements.size(); ++i)
-                {
-                    if (!elements[i]->discovered)
-                        continue;
+    /**
+     * Stream per-frame profiler stats to a CSV file
+     */
+    bool setProfileCsv(const std::string &path) { return profiler.openCsv(path); }
 
-                    sf::RectangleShape clickArea(sf::Vector2f(100, 30));
-                    clickArea.setPosition(705, 10 + discoveredIndex * 30 - sidebarScroll);
+    /**
+     * Repaint every frame (the old behaviour) instead of only when something changed
+     */
+    void setContinuousRedraw(bool enabled) { continuousRedraw = enabled; }
 
-                    // Only check if button is visible
-                    if (clickArea.getPosition().y >= -30 && clickArea.getPosition().y <= window.getSize().y)
-                    {
-                        if (clickArea.getGlobalBounds().contains(mousePos) && objects.size() < maxObjects)
-                        {
-                            std::string spritePath = "assets/" + elements[i]->name + ".png";
-                            auto obj = std::make_shared<GameObject>(elements[i], textures[elements[i]->name],
-                                                                    spritePath, sf::Vector2f(400, 300), clock.getElapsedTime().asSeconds());
-                            objects.push_back(obj);
-                            elements[i]->creationCount++;
-                            break;
-                        }
-                    }
-                    discoveredIndex++;
-                }
+    /**
+     * Reload the recipe pack and element and UI images whenever they are edited on disk
+     * Progress and the objects in the sandbox survive the reload.
+     */
+    bool startWatching()
+    {
+        if (!watcher.open())
+            return false;
+        watcher.watch(packFile);
+        for (const auto &elem : sim.elements)
+            watcher.watch(elem->texture);
+        for (const char *icon : {ElementBook::crossIconKey, ElementBook::bookIconKey, trashIconKey})
+            watcher.watch(icon);
+        watching = true;
+        return true;
+    }
 
-                // Check if clicking on existing objects to start dragging
-                for (auto &obj : objects)
-                {
-                    if (obj->sprite.getGlobalBounds().contains(mousePos))
-                    {
-                        obj->isDragging = true;
-                        draggingObject = obj;
-                        break;
-                    }
-                }
-            }
+    /**
+     * Record every frame and input event of this session to a log, starting from the current state
+     */
+    bool startRecording(const std::string &path) { return recorder.open(path, sim.snapshot()); }
 
-            // Handle mouse button release (end dragging)
-            if (event.type == sf::Event::MouseButtonReleased && event.mouseButton.button == sf::Mouse::Left)
+    /**
+     * Play an input log back instead of reading the window's input, then close
+     * The game first returns to the state the recording started from; frames run
+     * back to back (no frame-rate limit) with the recorded game times, and a
+     * timing summary is printed at the end. Saves go to this game's save file.
+     */
+    bool startReplay(const std::string &path, bool hidden)
+    {
+        if (!replay.load(path))
+            return false;
+        replaying = true;
+        writeSaveFile(autosave.getPath(), replay.getInitialState()); // So quick loads in the log find it
+        sim.restore(replay.getInitialState(), 0.0f);
+        for (ElementId id : sim.getDiscovered())
+            requestTexture(id);
+        updateHint();
+        savedRevision = sim.getRevision();
+        window.setFramerateLimit(0);
+        window.setVisible(!hidden);
+        replayFrameMs.reserve(replay.getFrameCount());
+        return true;
+    }
+
+    /**
+     * Main game loop - runs until window is closed
+     */
+    void run()
+    {
+        while (window.isOpen())
+        {
+            // Sleep until there is something to show instead of repainting an unchanged frame
+            sf::Event event;
+            bool woken = false;
+            if (replaying)
             {
-                if (draggingObject)
+                if (!replay.nextFrame(replayTime))
+                    break; // End of the log
+                // The window's own input is ignored during a replay, except for closing it to stop early
+                while (window.pollEvent(event))
                 {
-                    sf::Vector2f mousePos = window.mapPixelToCoords(sf::Vector2i(event.mouseButton.x, event.mouseButton.y));
-
-                    // Check if dropping object in trash bin
-                    if (draggingObject->sprite.getGlobalBounds().intersects(trashBin.getGlobalBounds()))
-                    {
-                        // Remove object from world
-                        objects.erase(std::remove_if(objects.begin(), objects.end(),
-                                                     [&](auto &o)
-                                                     { return o == draggingObject; }),
-                                      objects.end());
-                    }
-                    else
-                    {
-                        // Check for combinations with other objects
-                        checkCollisions(draggingObject, clock.getElapsedTime().asSeconds());
-                    }
+                    if (event.type == sf::Event::Closed)
+                        window.close();
+                }
+            }
+            else
+            {
+                woken = !needsRedraw() && waitForEvent(event);
+            }
 
-                    // Stop dragging
-                    draggingObject->isDragging = false;
-                    draggingObject = nullptr;
+            profiler.beginFrame();
+            frameArena.reset();
+            recorder.beginFrame(now());
+            {
+                FrameProfiler::ScopedTimer timer(profiler, FrameProfiler::Events);
+                handleEvents(woken ? &event : nullptr);
+            }
+            {
+                FrameProfiler::ScopedTimer timer(profiler, FrameProfiler::Update);
+                update(now());
+            }
+            if (needsRedraw())
+            {
+                {
+                    FrameProfiler::ScopedTimer timer(profiler, FrameProfiler::Draw);
+                    draw();
                 }
+                {
+                    // Present the frame to the screen (also waits for the frame-rate limit)
+                    FrameProfiler::ScopedTimer timer(profiler, FrameProfiler::Present);
+                    window.display();
+                }
+                dirty = false;
+                drawnRevision = sim.getRevision();
             }
+            profiler.endFrame(sim.objects.size());
+            const FrameProfiler::FrameStats &frame = profiler.getLastFrame();
+            particles.adaptBudget(frame.frameMs - frame.ms[FrameProfiler::Present]);
+            if (replaying)
+                replayFrameMs.push_back(profiler.getLastFrame().frameMs);
+        }
+
+        // Keep the progress of this session
+        saveGame();
+        autosave.flush();
+        if (replaying)
+            reportReplay();
+    }
+
+private:
+    /**
+     * Game time in seconds: the clock, or the recorded time of the frame while replaying
+     */
+    float now() const { return replaying ? replayTime : clock.getElapsedTime().asSeconds(); }
 
-            // Handle mouse movement while dragging
-            if (event.type == sf::Event::MouseMoved && draggingObject)
+    /**
+     * Next input event: from the window (recorded if a log is being written) or from the replayed frame
+     */
+    bool nextEvent(sf::Event &event)
+    {
+        if (replaying)
+            return replay.nextEvent(event);
+        if (!window.pollEvent(event))
+            return false;
+        recorder.record(event);
+        return true;
+    }
+
+    /**
+     * Print frame time statistics of a finished replay
+     */
+    void reportReplay()
+    {
+        std::vector<double> sorted = replayFrameMs;
+        std::sort(sorted.begin(), sorted.end());
+        double total = 0.0;
+        for (double ms : sorted)
+            total += ms;
+        auto percentile = [&](double p)
+        { return sorted.empty() ? 0.0 : sorted[static_cast<size_t>(p / 100.0 * (sorted.size() - 1))]; };
+        std::cout << "replay " << sorted.size() << " frames, " << total << " ms total, frame p50 " << percentile(50)
+                  << " ms, p99 " << percentile(99) << " ms, max " << percentile(100) << " ms\n";
+    }
+
+    /**
+     * Whether the screen is out of date: input, object or discovery changes,
+     * the invalid mark expiring, or the live profiler overlay
+     */
+    bool needsRedraw() const
+    {
+        return dirty || continuousRedraw || profiler.isOverlayVisible() || sim.getRevision() != drawnRevision ||
+               particles.getCount() > 0 || (invalidMarkShown && invalidMarkTime <= now());
+    }
+
+    /**
+     * Block until an event arrives, the next timed repaint is due or a loaded texture is ready
+     * Returns true if an event was received
+     */
+    bool waitForEvent(sf::Event &event)
+    {
+        if (!invalidMarkShown && !loader.isBusy() && !watching)
+            return window.waitEvent(event); // No deadline: sleep until input
+
+        // SFML 2's waitEvent() has no timeout, so poll with short sleeps until the invalid mark
+        // expires, a texture being loaded is ready to upload or a watched file changed.
+        // With only the watcher pending there is no deadline: block on it between polls instead,
+        // which wakes at once for an edit and only every watchPollInterval for input
+        while (window.isOpen() && !loader.hasFinished() && !(watching && watcher.hasChanges()) &&
+               (watching || loader.isBusy() || clock.getElapsedTime().asSeconds() < invalidMarkTime))
+        {
+            if (window.pollEvent(event))
+                return true;
+            if (loader.isBusy() || clock.getElapsedTime().asSeconds() < invalidMarkTime)
+                sf::sleep(idlePollInterval);
+            else
+                watcher.wait(watchPollInterval.asMilliseconds());
+        }
+        return false;
+    }
+
+    /**
+     * Handle all pending input events (after first, the event that woke the loop, if any)
+     * A burst of mouse moves is handled as its latest one: a high polling rate mouse
+     * queues many per frame and only the final position is ever drawn. A pending
+     * move is handled before the next other event, so presses and releases still see it.
+     */
+    void handleEvents(const sf::Event *first = nullptr)
+    {
+        sf::Event event;
+        sf::Event lastMove;
+        bool moved = false;
+        if (first)
+            recorder.record(*first);
+        if (first && first->type == sf::Event::MouseMoved)
+        {
+            lastMove = *first;
+            moved = true;
+        }
+        else if (first)
+        {
+            handleEvent(*first);
+        }
+
+        while (nextEvent(event))
+        {
+            if (event.type == sf::Event::MouseMoved)
             {
-                sf::Vector2f mousePos = window.mapPixelToCoords(sf::Vector2i(event.mouseMove.x, event.mouseMove.y));
-                draggingObject->sprite.setPosition(mousePos - sf::Vector2f(25, 25)); // Center sprite on mouse
+                lastMove = event;
+                moved = true;
+                continue;
             }
+            if (moved)
+                handleEvent(lastMove);
+            moved = false;
+            handleEvent(event);
         }
+        if (moved)
+            handleEvent(lastMove);
     }
 
     /**
-     * Check for collisions between dragged object and other objects
-     * Handle element combinations and invalid combination feedback
+     * Handle one input event (mouse clicks, window close, etc.)
      */
-    void checkCollisions(std::shared_ptr<GameObject> dragged, float time)
+    void handleEvent(const sf::Event &event)
     {
-        auto tempDragged = dragged;
-        std::vector<std::shared_ptr<GameObject>> toRemove;
+        // Anything but a bare mouse move can change what is on screen
+        if (event.type != sf::Event::MouseMoved || sim.isDragging() || panning || boxSelecting)
+        {
+            dirty = true;
+        }
 
-        // Check collision with each other object
-        for (auto it = objects.begin(); it != objects.end(); ++it)
+        // Handle window close button
+        if (event.type == sf::Event::Closed)
         {
-            auto &other = *it;
-            if (other == tempDragged || other->isDragging)
-                continue; // Skip self and other dragging objects
+            window.close();
+        }
 
-            // Check if sprites overlap
-            if (tempDragged->sprite.getGlobalBounds().intersects(other->sprite.getGlobalBounds()))
+        // Toggle the profiler overlay
+        if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::F3)
+        {
+            profiler.toggleOverlay();
+        }
+
+        // Toggle the next discovery hint
+        if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::H)
+        {
+            hintVisible = !hintVisible;
+        }
+
+        // Quick save and quick load
+        if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::F5)
+        {
+            saveGame();
+        }
+        if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::F9)
+        {
+            loadGame();
+        }
+
+        // Handle scroll wheel for right sidebar
+        if (event.type == sf::Event::MouseWheelScrolled)
+        {
+            sf::Vector2f mousePos = window.mapPixelToCoords(sf::Vector2i(event.mouseWheelScroll.x, event.mouseWheelScroll.y));
+
+            // Check if mouse is over right sidebar
+            if (mousePos.x > window.getSize().x - sidebarWidth && !book.isBookOpen())
             {
-                // Try to combine the elements
-                std::string result = registry.getResult(tempDragged->element->name, other->element->name);
+                sidebar.scrollBy(-event.mouseWheelScroll.delta * scrollSpeed);
+            }
+            else if (!book.isBookOpen())
+            {
+                zoomAt(sf::Vector2i(event.mouseWheelScroll.x, event.mouseWheelScroll.y), event.mouseWheelScroll.delta);
+            }
+        }
 
-                if (!result.empty())
-                {
-                    // Valid combination - remove both objects and create result
-                    toRemove.push_back(tempDragged);
-                    toRemove.push_back(other);
+        // Let book handle its input first
+        book.handleInput(event, window);
 
-                    // Find the result element and create new object
-                    for (auto &elem : elements)
-                    {
-                        if (elem->name == result)
-                        {
-                            elem->discovered = true; // Discover the new element
-                            elem->creationCount++;
-                            std::string spritePath = "assets/" + result + ".png";
-                            auto newObj = std::make_shared<GameObject>(elem, textures[result],
-                                                                       spritePath,
-                                                                       (tempDragged->sprite.getPosition() + other->sprite.getPosition()) / 2.0f,
-                                                                       time);
-                            objects.push_back(newObj);
-                            break;
-                        }
-                    }
-                    break;
+        // Skip game input handling if book is open
+        if (book.isBookOpen())
+        {
+            return;
+        }
+
+        // Handle mouse button press
+        if (event.type == sf::Event::MouseButtonPressed && event.mouseButton.button == sf::Mouse::Left)
+        {
+            sf::Vector2f mousePos = window.mapPixelToCoords(sf::Vector2i(event.mouseButton.x, event.mouseButton.y));
+
+            // Check if clicking on element buttons in right sidebar (the row follows from the y coordinate)
+            // New objects appear at the same spot on screen wherever the camera is
+            long row = sidebar.rowAt(mousePos);
+            if (row >= 0)
+                sim.spawn(sim.getDiscovered()[static_cast<size_t>(row)], window.mapPixelToCoords(sf::Vector2i(400, 300), camera),
+                          now());
+
+            // Check if clicking on existing objects to start dragging (topmost object wins);
+            // pressing on empty sandbox space starts a box selection instead
+            sf::Vector2i pixel(event.mouseButton.x, event.mouseButton.y);
+            if (inSandbox(pixel))
+            {
+                sf::Vector2f worldPos = window.mapPixelToCoords(pixel, camera);
+                ObjectHandle picked = sim.pick(worldPos);
+                sim.beginDrag(picked);
+                boxSelecting = picked.isNull();
+                boxStart = boxEnd = worldPos;
+            }
+        }
+
+        // Grow the selection box with the mouse, then select what it covers
+        if (event.type == sf::Event::MouseMoved && boxSelecting)
+        {
+            boxEnd = window.mapPixelToCoords(sf::Vector2i(event.mouseMove.x, event.mouseMove.y), camera);
+        }
+        if (event.type == sf::Event::MouseButtonReleased && event.mouseButton.button == sf::Mouse::Left && boxSelecting)
+        {
+            boxSelecting = false;
+            sf::FloatRect box = selectionBox();
+            if (box.width < 4 && box.height < 4)
+                sim.clearSelection(); // A plain click on empty space deselects
+            else
+                sim.select(box);
+        }
+
+        // Combine every overlapping pair in the selection (or the whole sandbox) at once
+        if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::C)
+        {
+            CombineAllResult combined = sim.combineAll(now());
+            for (ObjectHandle created : combined.created)
+            {
+                ElementId element = sim.objects.elementIds[sim.objects.indexOf(created)];
+                burstAt(created, std::find(combined.discovered.begin(), combined.discovered.end(), element) !=
+                                     combined.discovered.end());
+            }
+            for (ElementId id : combined.discovered)
+                requestTexture(id);
+            if (!combined.discovered.empty())
+                updateHint();
+        }
+        if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::Escape)
+        {
+            sim.clearSelection();
+        }
+
+        // Pan the camera with the right mouse button
+        if (event.type == sf::Event::MouseButtonPressed && event.mouseButton.button == sf::Mouse::Right)
+        {
+            panLast = sf::Vector2i(event.mouseButton.x, event.mouseButton.y);
+            panning = inSandbox(panLast);
+        }
+        if (event.type == sf::Event::MouseButtonReleased && event.mouseButton.button == sf::Mouse::Right)
+        {
+            panning = false;
+        }
+        if (event.type == sf::Event::MouseMoved && panning)
+        {
+            sf::Vector2i pixel(event.mouseMove.x, event.mouseMove.y);
+            camera.move(window.mapPixelToCoords(panLast, camera) - window.mapPixelToCoords(pixel, camera));
+            panLast = pixel;
+        }
+
+        // Handle mouse button release (end dragging)
+        if (event.type == sf::Event::MouseButtonReleased && event.mouseButton.button == sf::Mouse::Left)
+        {
+            ObjectHandle dropped = sim.endDrag();
+            if (!dropped.isNull())
+            {
+                // Check if dropping object in trash bin (drawn over the world, so compare in world space)
+                sf::Vector2f trashTopLeft = window.mapPixelToCoords(sf::Vector2i(trashBin.left, trashBin.top), camera);
+                sf::Vector2f trashBottomRight = window.mapPixelToCoords(
+                    sf::Vector2i(trashBin.left + trashBin.width, trashBin.top + trashBin.height), camera);
+                if (sim.objectBounds(sim.objects.indexOf(dropped)).intersects(sf::FloatRect(trashTopLeft, trashBottomRight - trashTopLeft)))
+                {
+                    // Remove object from world
+                    sim.removeObject(dropped);
                 }
                 else
                 {
-                    // Invalid combination - show red X and make other object semi-transparent
-                    invalidMarkPos = (tempDragged->sprite.getPosition() + other->sprite.getPosition()) / 2.0f;
-                    invalidMarkTime = time + 1.0f;                         // Show for 1 second
-                    other->sprite.setColor(sf::Color(255, 255, 255, 128)); // Semi-transparent
+                    // Check for combinations with other objects
+                    float time = now();
+                    DropResult drop;
+                    {
+                        FrameProfiler::ScopedTimer timer(profiler, FrameProfiler::Collisions);
+                        drop = sim.checkCollisions(dropped, time);
+                    }
+                    if (drop.combined)
+                        burstAt(drop.created, drop.discovered);
+                    if (drop.discovered)
+                    {
+                        requestTexture(drop.result);
+                        updateHint();
+                    }
+                    if (drop.invalid)
+                    {
+                        // Invalid combination - show red X
+                        invalidMarkPos = drop.position;
+                        invalidMarkTime = time + 1.0f; // Show for 1 second
+                    }
                 }
             }
         }
 
-        // Remove objects that were used in combinations
-        if (!toRemove.empty())
+        // Handle mouse movement while dragging
+        if (event.type == sf::Event::MouseMoved && sim.isDragging())
         {
-            objects.erase(
-                std::remove_if(objects.begin(), objects.end(),
-                               [&](const auto &obj)
-                               { return std::find(toRemove.begin(), toRemove.end(), obj) != toRemove.end(); }),
-                objects.end());
+            sf::Vector2f mousePos = window.mapPixelToCoords(sf::Vector2i(event.mouseMove.x, event.mouseMove.y), camera);
+            sim.dragTo(mousePos - sf::Vector2f(25, 25)); // Center sprite on mouse
         }
     }
 
+    /**
+     * World-space rectangle between the selection box corners
+     */
+    sf::FloatRect selectionBox() const
+    {
+        sf::Vector2f topLeft(std::min(boxStart.x, boxEnd.x), std::min(boxStart.y, boxEnd.y));
+        sf::Vector2f bottomRight(std::max(boxStart.x, boxEnd.x), std::max(boxStart.y, boxEnd.y));
+        return sf::FloatRect(topLeft, bottomRight - topLeft);
+    }
+
+    /**
+     * Whether a window pixel lies in the sandbox area (left of the sidebar)
+     */
+    bool inSandbox(sf::Vector2i pixel) const
+    {
+        sf::Vector2f size(window.getSize());
+        return pixel.x >= 0 && pixel.y >= 0 && pixel.x < size.x - sidebarWidth && pixel.y < size.y;
+    }
+
+    /**
+     * Zoom the camera by scroll steps, keeping the world point under the mouse in place
+     */
+    void zoomAt(sf::Vector2i pixel, float steps)
+    {
+        sf::Vector2f before = window.mapPixelToCoords(pixel, camera);
+        float zoom = camera.getSize().x / (window.getSize().x - sidebarWidth); // World units per pixel
+        float target = std::max(minZoom, std::min(maxZoom, zoom * std::pow(zoomStep, -steps)));
+        camera.zoom(target / zoom);
+        camera.move(before - window.mapPixelToCoords(pixel, camera));
+    }
+
     /**
      * Update game state each frame
      */
     void update(float time)
     {
-        // Remove oldest objects if over the limit
-        while (objects.size() > maxObjects)
+        sim.update(time);
         {
-            auto oldest = std::min_element(objects.begin(), objects.end(),
-                                           [](auto &a, auto &b)
-                                           { return a->creationTime < b->creationTime; });
-            objects.erase(oldest);
+            FrameProfiler::ScopedTimer timer(profiler, FrameProfiler::Particles);
+            particles.update(std::max(0.0f, std::min(time - particleTime, maxParticleStep)));
+            particleTime = time;
         }
 
-        // Reset all object colors to white (remove semi-transparency from failed combinations)
-        for (auto &obj : objects)
+        // Preview the drop once per frame, and only when something moved
+        if (!sim.isDragging())
+            hoverPreview = DropPreview();
+        else if (sim.getRevision() != previewRevision)
+            hoverPreview = sim.previewDrop();
+        previewRevision = sim.getRevision();
+
+        if (watching && watcher.hasChanges())
+            applyFileChanges();
+        sidebar.setCount(sim.getDiscovered().size()); // Discoveries lengthen the list
+        uploadLoadedTextures();
+
+        // Autosave now and then, but only if something changed
+        if (time >= nextAutosave && sim.getRevision() != savedRevision)
+            saveGame();
+    }
+
+    /**
+     * Snapshot the game and hand it to the autosave thread (only the copy happens here)
+     */
+    void saveGame()
+    {
+        autosave.submit(sim.snapshot());
+        savedRevision = sim.getRevision();
+        nextAutosave = now() + autosaveInterval;
+    }
+
+    /**
+     * Replace the game state with the save file's, if there is a valid one
+     */
+    bool loadGame()
+    {
+        autosave.flush(); // Never read a save that is still being written
+        SaveState state;
+        if (!readSaveFile(autosave.getPath(), state))
+            return false;
+
+        sim.restore(state, now());
+        for (ElementId id : sim.getDiscovered())
+            requestTexture(id); // Elements discovered in the save load like fresh discoveries
+        savedRevision = sim.getRevision();
+        updateHint();
+        dirty = true;
+        return true;
+    }
+
+    /**
+     * Find the cheapest discovery the discovered elements allow and describe it
+     */
+    void updateHint()
+    {
+        hint = explorer.hint(sim.getDiscoveredSet());
+        std::string text = "Hint: nothing left to discover";
+        if (hint.isValid())
         {
-            obj->sprite.setColor(sf::Color::White);
+            text = "Hint: try ";
+            for (std::uint16_t k = 0; k < hint.formula->count; ++k)
+                text += (k ? " + " : "") + sim.elements[hint.formula->ingredients[k]]->name;
         }
+        hintText.setString(text);
     }
 
     /**
-     * Render all game elements to the screen
+     * Start loading the texture of an element whose loading was deferred
      */
-    void draw()
+    void requestTexture(ElementId id)
     {
-        window.clear(sf::Color(255, 255, 255)); // Background
+        if (deferredTextures[id].empty())
+            return; // Already loaded or requested
+        loader.request(deferredTextures[id], elementVariants(*sim.elements[id]));
+        deferredTextures[id].clear();
+    }
 
-        sf::Vector2u windowSize = window.getSize();
-        float sidebarWidth = 100.0f;
+    /**
+     * Sizes an element image is kept at in the atlas: the sandbox sprite at half the
+     * source size (the old 50% sprite scale) and the sidebar/book row icon
+     * A missing or unreadable file is treated as 50x50, the size of its fallback square
+     */
+    std::vector<ImageLoader::Variant> elementVariants(const Element &elem) const
+    {
+        sf::Vector2u size;
+        if (!readPngSize(&archive, elem.texture, size))
+            size = sf::Vector2u(50, 50);
+        sf::Vector2u spriteSize(std::max(1u, size.x / 2), std::max(1u, size.y / 2));
+        sf::Vector2u iconSize(ElementBook::iconSize, ElementBook::iconSize);
+        return {{elem.name, spriteSize}, {ElementBook::iconKey(elem.name), iconSize}};
+    }
 
-        // Draw main sandbox area (left side)
-        sf::RectangleShape sandbox(sf::Vector2f(windowSize.x - sidebarWidth, windowSize.y));
-        sandbox.setPosition(0, 0);
-        sandbox.setFillColor(sf::Color(243, 124, 84)); // Main sandbox color
-        window.draw(sandbox);
+    /**
+     * Upload images the loader finished decoding into their reserved atlas regions
+     */
+    void uploadLoadedTextures()
+    {
+        std::vector<std::string> resized; // Keys of images edited to a new size
+        for (auto &loaded : loader.collect())
+        {
+            if (!loaded.ok)
+                std::cerr << "Failed to load texture: " << loaded.path << "\n";
 
-        // Draw right sidebar for element buttons
-        sf::RectangleShape rightTab(sf::Vector2f(sidebarWidth, windowSize.y));
-        rightTab.setPosition(windowSize.x - sidebarWidth, 0);
-        rightTab.setFillColor(sf::Color(255, 194, 77)); // Light gray
-        window.draw(rightTab);
+            for (size_t i = 0; i < loaded.variants.size(); ++i)
+            {
+                const TextureAtlas::Region *region = atlas.find(loaded.variants[i].key);
+                if (!region)
+                    continue;
+
+                // Use the shared magenta square (of the reserved size) if texture loading fails
+                sf::Vector2u reserved(region->rect.width, region->rect.height);
+                if (!loaded.ok)
+                    atlas.update(loaded.variants[i].key, resources.get(resources.fallbackImage(reserved, sf::Color::Magenta)));
+                else if (loaded.images[i].getSize() != reserved)
+                {
+                    atlas.add(loaded.variants[i].key, loaded.images[i]); // Replaces its region when packed below
+                    resized.push_back(loaded.variants[i].key);
+                }
+                else
+                    atlas.update(loaded.variants[i].key, loaded.images[i]);
+            }
+            dirty = true;
+        }
+        if (resized.empty())
+            return;
 
-        // Draw discovered element buttons in right sidebar with scrolling
-        int discoveredIndex = 0;
-        for (size_t i = 0; i < elements.size(); ++i)
+        // Region pointers stay valid across build(); only the sprite sizes change
+        atlas.build();
+        for (const std::string &key : resized)
+        {
+            ElementId id = sim.registry.getId(key);
+            const TextureAtlas::Region *region = atlas.find(key);
+            if (id != NoElement && region)
+                sim.setElementSize(id, sf::Vector2f(region->rect.width, region->rect.height));
+        }
+    }
+
+    /**
+     * Resolve the atlas regions of every element once so per-object drawing never
+     * looks names up, and give the elements to the book
+     * Runs after the atlas is built and again whenever element ids change.
+     * Sandbox sprites are already stored at the size they are drawn at.
+     */
+    void indexElements()
+    {
+        elementRegions.clear();
+        iconRegions.clear();
+        labelRegions.clear();
+        book.clearElements();
+        for (auto &elem : sim.elements)
+        {
+            const TextureAtlas::Region *region = atlas.find(elem->name);
+            elementRegions.push_back(region);
+            iconRegions.push_back(atlas.find(ElementBook::iconKey(elem->name)));
+            labelRegions.push_back(atlas.find(ElementBook::labelKey(elem->name)));
+            if (region)
+                sim.setElementSize(elem->id, sf::Vector2f(region->rect.width, region->rect.height));
+            book.addElement(elem);
+        }
+    }
+
+    /**
+     * Check the pack: everything should be reachable from the basic elements
+     * Leaves the explorer indexed for hints.
+     */
+    void checkPack()
+    {
+        explorer.build(sim.registry, sim.elements.size());
+        std::vector<ElementId> basics;
+        for (size_t i = 0; i < sim.elements.size(); ++i)
+        {
+            if (sim.pack.isBasic(i))
+                basics.push_back(static_cast<ElementId>(i));
+        }
+        explorer.report(explorer.explore(basics), sim.elements, std::cerr);
+    }
+
+    /**
+     * Apply edits to watched files: a new recipe pack first, then changed images
+     */
+    void applyFileChanges()
+    {
+        std::vector<std::string> changed;
+        watcher.poll(changed);
+        auto pack = std::find(changed.begin(), changed.end(), packFile);
+        if (pack != changed.end())
+        {
+            changed.erase(pack);
+            reloadPack();
+        }
+        if (!changed.empty())
+            reloadImages(changed);
+    }
+
+    /**
+     * Switch to the edited recipe pack, keeping progress and the sandbox
+     * Only new elements and elements whose image path changed get atlas space and
+     * images; the others keep their regions under their new ids.
+     */
+    void reloadPack()
+    {
+        sf::Clock timer;
+        std::vector<std::string> oldNames;
+        std::vector<std::string> oldTextures;
+        for (const auto &elem : sim.elements)
+        {
+            oldNames.push_back(elem->name);
+            oldTextures.push_back(elem->texture);
+        }
+        std::vector<ElementId> remap;
+        if (!sim.reloadPack(packFile, remap))
+        {
+            std::cerr << "Keeping the current recipe pack\n";
+            return;
+        }
+
+        std::vector<std::string> oldDeferred = std::move(deferredTextures);
+        deferredTextures.assign(sim.elements.size(), std::string());
+        std::vector<bool> kept(sim.elements.size(), false);
+        size_t added = 0;
+        size_t removed = 0;
+        bool repack = false;
+        for (size_t old = 0; old < remap.size(); ++old)
         {
-            if (elements[i]->discovered)
+            if (remap[old] == NoElement)
             {
-                float yPos = 10 + discoveredIndex * 30 - sidebarScroll;
+                // Removed element: free its sprite, icon and label (indexElements() drops the pointers)
+                atlas.remove(oldNames[old]);
+                atlas.remove(ElementBook::iconKey(oldNames[old]));
+                atlas.remove(ElementBook::labelKey(oldNames[old]));
+                removed++;
+                repack = true;
+                continue;
+            }
+            const Element &elem = *sim.elements[remap[old]];
+            kept[elem.id] = true;
+            bool deferred = !oldDeferred[old].empty();
+            if (deferred)
+                deferredTextures[elem.id] = elem.texture;
+            if (elem.texture == oldTextures[old])
+                continue;
 
-                // Only draw if visible
-                if (yPos >= -30 && yPos <= windowSize.y)
-                {
-                    // Draw element icon
-                    sf::Sprite icon;
-                    auto it = textures.find(elements[i]->name);
-                    if (it != textures.end())
-                    {
-                        icon.setTexture(it->second);
-                        icon.setScale(20.0f / it->second.getSize().x, 20.0f / it->second.getSize().y);
-                        icon.setPosition(705, yPos);
-                        window.draw(icon);
-                    }
+            // Same element, other image: reserve its new size or load it right away
+            watcher.watch(elem.texture);
+            if (deferred)
+            {
+                for (const auto &variant : elementVariants(elem))
+                    atlas.reserve(variant.key, variant.size);
+                repack = true;
+            }
+            else
+            {
+                loader.request(elem.texture, elementVariants(elem));
+            }
+        }
+        for (const auto &elem : sim.elements)
+        {
+            if (kept[elem->id])
+                continue;
+
+            // New element: its label and reserved images, loaded now if it starts out discovered
+            std::vector<ImageLoader::Variant> variants = elementVariants(*elem);
+            for (const auto &variant : variants)
+                atlas.reserve(variant.key, variant.size);
+            atlas.addText(ElementBook::labelKey(elem->name), elem->name, font, 20, sf::Color::Black);
+            deferredTextures[elem->id] = elem->texture;
+            if (elem->discovered)
+                requestTexture(elem->id);
+            watcher.watch(elem->texture);
+            added++;
+            repack = true;
+        }
+        if (repack)
+            atlas.build();
+
+        indexElements();
+        sidebar.setCount(sim.getDiscovered().size());
+        checkPack();
+        updateHint();
+        hoverPreview = DropPreview(); // Holds an old id until recomputed
+        previewRevision = ~0ull;
+        dirty = true;
+        std::cerr << "Reloaded " << packFile << ": " << sim.elements.size() << " elements (" << added << " new, "
+                  << removed << " removed) in " << timer.getElapsedTime().asMilliseconds() << " ms\n";
+    }
 
-                    // Draw element name
-                    sf::Text text(elements[i]->name, font, 20);
-                    text.setPosition(730, yPos);
-                    text.setFillColor(sf::Color::Black);
-                    window.draw(text);
+    /**
+     * Reload edited images into the atlas regions that show them
+     */
+    void reloadImages(const std::vector<std::string> &paths)
+    {
+        bool repack = false;
+        for (const std::string &path : paths)
+        {
+            // UI icons are few and small: decode and upload them in place right away
+            if (path == ElementBook::crossIconKey || path == ElementBook::bookIconKey || path == trashIconKey)
+            {
+                sf::Image image;
+                if (image.loadFromFile(path))
+                    atlas.update(path, resizeImage(image, sf::Vector2u(uiIconSize, uiIconSize)));
+                dirty = true;
+                continue;
+            }
+
+            // Element images load on the workers; not yet loaded ones only get their reservation resized
+            for (const auto &elem : sim.elements)
+            {
+                if (elem->texture != path)
+                    continue;
+                if (deferredTextures[elem->id].empty())
+                {
+                    loader.request(path, elementVariants(*elem));
+                    continue;
                 }
-                discoveredIndex++;
+                for (const auto &variant : elementVariants(*elem))
+                    atlas.reserve(variant.key, variant.size);
+                repack = true;
             }
         }
+        if (repack)
+        {
+            atlas.build();
+            indexElements();
+        }
+    }
 
-        // Draw all game objects (except currently dragged one)
-        for (auto &obj : objects)
+    /**
+     * Start a combination burst (or a discovery burst) at the centre of a new object
+     */
+    void burstAt(ObjectHandle created, bool discovered)
+    {
+        if (!sim.objects.isAlive(created))
+            return;
+        sf::FloatRect bounds = sim.objectBounds(sim.objects.indexOf(created));
+        particles.burst(sf::Vector2f(bounds.left + bounds.width / 2, bounds.top + bounds.height / 2),
+                        discovered ? discoveryBurst : combineBurst);
+    }
+
+    /**
+     * Queue the sprite of the object at a dense index into the batch
+     */
+    void queueObject(size_t index)
+    {
+        const ObjectPool &objects = sim.objects;
+        if (const TextureAtlas::Region *region = elementRegions[objects.elementIds[index]])
+        {
+            sf::Color tint = (objects.flags[index] & ObjectDimmed)     ? sf::Color(255, 255, 255, 128)
+                             : (objects.flags[index] & ObjectSelected) ? sf::Color(170, 210, 255) // Light blue highlight
+                                                                       : sf::Color::White;
+            worldBatch.add(*region, sim.objectBounds(index), tint);
+        }
+    }
+
+    /**
+     * Render all game elements to the back buffer (run() presents it)
+     */
+    void draw()
+    {
+        window.clear(sf::Color(255, 255, 255)); // Background
+
+        // Draw main sandbox area (left side) and right sidebar for element buttons
+        profiler.draw(window, sandboxPanel);
+        profiler.draw(window, sidebarPanel);
+
+        // All atlas quads below are queued in painter's order and drawn together at the end:
+        // the world through the camera, then the UI on top of it
+        batch.clear();
+        worldBatch.clear();
+
+        // Draw discovered element buttons in right sidebar with scrolling
+        {
+            FrameProfiler::ScopedTimer timer(profiler, FrameProfiler::Sidebar);
+
+            // Only the rows inside the window are visited: element icon and pre-rendered name
+            const std::vector<ElementId> &discovered = sim.getDiscovered();
+            queueElementRows(batch, sidebar, 705, ElementBook::iconSize,
+                             [&](size_t row, const TextureAtlas::Region *&icon, const TextureAtlas::Region *&label)
+                             {
+                                 icon = iconRegions[discovered[row]];
+                                 label = labelRegions[discovered[row]];
+                             });
+        }
+
+        // Queue the game objects inside the camera (except currently dragged one), found through the spatial grid
+        sf::FloatRect visibleArea(camera.getCenter() - camera.getSize() / 2.0f, camera.getSize());
+        std::pmr::vector<size_t> visibleObjects(&frameArena);
+        sim.queryArea(visibleArea, visibleObjects);
+        for (size_t i : visibleObjects)
         {
-            if (!obj->isDragging)
-                window.draw(obj->sprite);
+            if (!(sim.objects.flags[i] & ObjectDragging))
+                queueObject(i);
         }
 
-        // Draw dragged object on top of everything else
-        if (draggingObject)
-            window.draw(draggingObject->sprite);
+        // Queue dragged object on top of everything else
+        if (sim.isDragging())
+            queueObject(sim.objects.indexOf(sim.getDragging()));
+
+        // Queue trash bin
+        if (const TextureAtlas::Region *trash = atlas.find(trashIconKey))
+            batch.add(*trash, trashBin);
+
+        // Queue invalid combination marker (red X) if needed
+        const TextureAtlas::Region *cross = atlas.find(ElementBook::crossIconKey);
+        invalidMarkShown = invalidMarkTime > now();
+        if (cross && invalidMarkShown)
+        {
+            worldBatch.add(*cross, sf::FloatRect(invalidMarkPos.x, invalidMarkPos.y, 24, 24), sf::Color::Red);
+        }
+
+        // Queue the hover preview above the dragged object: the result's icon (a "???" label
+        // for an undiscovered one) or a faded invalid mark
+        if (hoverPreview.overlaps)
+        {
+            sf::Vector2f at = hoverPreview.position;
+            ElementId result = hoverPreview.result;
+            const TextureAtlas::Region *icon = result == NoElement ? nullptr
+                                               : sim.isDiscovered(result) ? iconRegions[result]
+                                                                          : atlas.find(ElementBook::unknownLabelKey);
+            if (icon)
+                worldBatch.add(*icon, sf::FloatRect(at.x, at.y, icon->rect.width, icon->rect.height));
+            else if (cross && result == NoElement)
+                worldBatch.add(*cross, sf::FloatRect(at.x, at.y, 24, 24), sf::Color(255, 0, 0, 128));
+        }
 
-        // Draw trash bin
-        window.draw(trashBin);
+        // Queue book icon
+        if (const TextureAtlas::Region *bookIcon = atlas.find(ElementBook::bookIconKey))
+            batch.add(*bookIcon, book.getIconBounds());
 
-        // Draw invalid combination marker (red X) if needed
-        if (invalidMarkTime > clock.getElapsedTime().asSeconds())
+        // Draw every queued object and icon (one draw call per atlas page run)
+        sf::View screen = window.getView();
+        window.setView(camera);
+        profiler.countDrawCalls(worldBatch.draw(window));
+        if (particles.getCount() > 0)
         {
-            invalidMark.setPosition(invalidMarkPos);
-            window.draw(invalidMark);
+            FrameProfiler::ScopedTimer timer(profiler, FrameProfiler::Particles);
+            profiler.draw(window, particles.buildVertices());
         }
+        if (boxSelecting)
+        {
+            sf::FloatRect box = selectionBox();
+            selectionOutline.setPosition(box.left, box.top);
+            selectionOutline.setSize(sf::Vector2f(box.width, box.height));
+            selectionOutline.setOutlineThickness(camera.getSize().x / camera.getViewport().width / window.getSize().x); // 1 pixel at any zoom
+            profiler.draw(window, selectionOutline);
+        }
+        window.setView(screen);
+        profiler.countDrawCalls(batch.draw(window));
+
+        // Draw the next discovery hint next to the trash bin
+        if (hintVisible)
+            profiler.draw(window, hintText);
 
         // Draw the element book interface
-        book.draw(window, clock.getElapsedTime().asSeconds());
+        {
+            FrameProfiler::ScopedTimer timer(profiler, FrameProfiler::Book);
+            book.draw(window, now(), profiler);
+        }
 
-        // Present the frame to the screen
-        window.display();
-    }  
+        // Draw the profiler overlay last so it sits above everything
+        profiler.drawOverlay(window);
+    }
 };
 
 /**
  * Program entry point - creates and runs the game
  */
-int main()
+int main(int argc, char **argv)
 {
-    Game game;
+    // Optional object cap: ./game --max-objects 100000
+    // Optional profiler CSV: ./game --profile-csv frames.csv
+    // Repaint at 60 FPS even when idle: ./game --continuous-redraw
+    // Other recipe pack: ./game --pack packs/custom.pack
+    // Other save file: ./game --save other.sav
+    // Record input: ./game --record session.log
+    // Replay input: ./game --replay session.log [--hidden] (saves go to session.log.sav)
+    // Reload the pack and images when they are edited: ./game --watch (reads loose files, not the archive)
+    // Other asset archive: ./game --assets other.pak (assets.pak is used when it exists)
+    size_t maxObjects = 50;
+    std::string packPath = Simulation::DefaultPackPath;
+    std::string savePath = Game::DefaultSavePath;
+    const char *profileCsv = nullptr;
+    bool continuousRedraw = false;
+    const char *recordPath = nullptr;
+    const char *replayPath = nullptr;
+    bool hidden = false;
+    bool watch = false;
+    std::string archivePath;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--max-objects") == 0 && i + 1 < argc)
+            maxObjects = std::strtoul(argv[++i], nullptr, 10);
+        else if (std::strcmp(argv[i], "--profile-csv") == 0 && i + 1 < argc)
+            profileCsv = argv[++i];
+        else if (std::strcmp(argv[i], "--pack") == 0 && i + 1 < argc)
+            packPath = argv[++i];
+        else if (std::strcmp(argv[i], "--save") == 0 && i + 1 < argc)
+            savePath = argv[++i];
+        else if (std::strcmp(argv[i], "--continuous-redraw") == 0)
+            continuousRedraw = true;
+        else if (std::strcmp(argv[i], "--record") == 0 && i + 1 < argc)
+            recordPath = argv[++i];
+        else if (std::strcmp(argv[i], "--replay") == 0 && i + 1 < argc)
+            replayPath = argv[++i];
+        else if (std::strcmp(argv[i], "--hidden") == 0)
+            hidden = true;
+        else if (std::strcmp(argv[i], "--watch") == 0)
+            watch = true;
+        else if (std::strcmp(argv[i], "--assets") == 0 && i + 1 < argc)
+            archivePath = argv[++i];
+    }
+
+    // Ship with the packed archive; edited assets are only picked up from loose files
+    if (archivePath.empty() && std::ifstream(Game::DefaultArchivePath))
+        archivePath = Game::DefaultArchivePath;
+    if (watch && !replayPath)
+        archivePath.clear();
+
+    // A replay never touches the real save file
+    if (replayPath)
+        savePath = std::string(replayPath) + ".sav";
+
+    Game game(maxObjects, packPath, savePath, archivePath);
+    game.setContinuousRedraw(continuousRedraw);
+    if (profileCsv && !game.setProfileCsv(profileCsv))
+        std::cerr << "Failed to open profiler CSV file: " << profileCsv << "\n";
+    if (replayPath && !game.startReplay(replayPath, hidden))
+        return 1;
+    if (recordPath && !replayPath)
+        game.startRecording(recordPath);
+    if (watch && !replayPath)
+        game.startWatching();
     game.run();
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <utility>
+#include <cstdio>
+#ifdef _WIN32
+#include <fstream>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+/**
+ * MappedFile gives read-only access to the bytes of a whole file
+ * On POSIX systems the file is memory-mapped, so nothing is read until it is
+ * touched; on Windows it is read into a buffer instead
+ */
+class MappedFile
+{
+    const char *bytes = nullptr; // Start of the file contents
+    size_t length = 0;           // File size in bytes
+#ifdef _WIN32
+    std::vector<char> buffer;    // File contents (no mapping on this platform)
+#endif
+
+public:
+    MappedFile() = default;
+    ~MappedFile() { close(); }
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    /**
+     * Map a file, replacing any file mapped before
+     * Returns false if the file is missing or empty
+     */
+    bool open(const std::string &path)
+    {
+        close();
+#ifdef _WIN32
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if (!file)
+            return false;
+        std::streamsize size = file.tellg();
+        if (size <= 0)
+            return false;
+        buffer.resize(static_cast<size_t>(size));
+        file.seekg(0);
+        if (!file.read(buffer.data(), size))
+        {
+            buffer.clear();
+            return false;
+        }
+        bytes = buffer.data();
+        length = buffer.size();
+        return true;
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return false;
+
+        struct stat info;
+        if (fstat(fd, &info) != 0 || info.st_size <= 0)
+        {
+            ::close(fd);
+            return false;
+        }
+
+        void *mapping = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd); // The mapping stays valid after the descriptor is closed
+        if (mapping == MAP_FAILED)
+            return false;
+
+        bytes = static_cast<const char *>(mapping);
+        length = static_cast<size_t>(info.st_size);
+        return true;
+#endif
+    }
+
+    /**
+     * Unmap the file (no-op if nothing is mapped)
+     */
+    void close()
+    {
+#ifdef _WIN32
+        buffer.clear();
+#else
+        if (bytes)
+            munmap(const_cast<char *>(bytes), length);
+#endif
+        bytes = nullptr;
+        length = 0;
+    }
+
+    /**
+     * Exchange files with another MappedFile (nothing is remapped, so pointers into either stay valid)
+     */
+    void swap(MappedFile &other)
+    {
+        std::swap(bytes, other.bytes);
+        std::swap(length, other.length);
+#ifdef _WIN32
+        buffer.swap(other.buffer);
+#endif
+    }
+
+    bool isOpen() const { return bytes != nullptr; }
+    const char *data() const { return bytes; }
+    size_t size() const { return length; }
+};
+
+/**
+ * Move a finished temporary file over its target
+ * On POSIX rename() replaces the target atomically, so the target always holds
+ * either the old or the new contents, even after a crash. Windows' rename()
+ * refuses to replace a file, so there the target is removed first and a crash
+ * in between leaves only the temporary file.
+ */
+inline bool replaceFile(const std::string &tempPath, const std::string &path)
+{
+#ifdef _WIN32
+    std::remove(path.c_str());
+#endif
+    return std::rename(tempPath.c_str(), path.c_str()) == 0;
+}
@@ -0,0 +1,517 @@
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <functional>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+#include "simulation.hpp"
+#include "sprite_batch.hpp"
+#include "recipe_service.hpp"
+
+/*
+Micro-benchmarks of the game's hot paths, with machine-readable results:
+recipe lookups (hits and misses), drop collision checks, object eviction,
+building the sidebar and book draw lists and answering recipe service requests. Draw lists are only built into a
+sprite batch, never drawn, so no window or display server is needed.
+
+Compilation instructions:
+g++ -c microbench.cpp -o microbench.o -std=c++17 -O2 -pthread
+g++ microbench.o -o microbench -lsfml-graphics -lsfml-window -lsfml-system -pthread
+
+Usage:
+./microbench [--out results.json] [--filter text] [--min-time ms] [--seed N]
+
+Results are written as JSON to --out (default: standard output):
+
+    {"schema": 1, "seed": 1, "benchmarks": [
+        {"name": "registry.getResult", "params": {"elements": 1000, "hit_rate": 0.5},
+         "samples": 2000, "ops_per_sample": 1024, "mean_ns": 8.1, "p50_ns": 8.0, "p99_ns": 9.7}, ...]}
+
+Times are per operation. Benchmarks whose ops change state between runs
+(collisions, eviction) take one sample per op; cheap ones time batches of
+ops so timer overhead does not dominate. --filter keeps only benchmarks
+whose name contains the text.
+*/
+
+/**
+ * Result of one benchmark run
+ */
+struct BenchResult
+{
+    std::string name;
+    std::vector<std::pair<std::string, double>> params; // Workload parameters, in output order
+    std::vector<double> samples;                        // Time per op of each sample, in nanoseconds
+    size_t opsPerSample = 1;
+
+    BenchResult(std::string benchName, std::vector<std::pair<std::string, double>> workload)
+        : name(std::move(benchName)), params(std::move(workload))
+    {
+    }
+
+    double percentile(double p) const
+    {
+        if (samples.empty())
+            return 0.0;
+        std::vector<double> sorted = samples;
+        std::sort(sorted.begin(), sorted.end());
+        return sorted[static_cast<size_t>(p / 100.0 * (sorted.size() - 1))];
+    }
+
+    double mean() const
+    {
+        double total = 0.0;
+        for (double ns : samples)
+            total += ns;
+        return samples.empty() ? 0.0 : total / samples.size();
+    }
+
+    void writeJson(std::ostream &out) const
+    {
+        out << "    {\"name\": \"" << name << "\", \"params\": {";
+        for (size_t i = 0; i < params.size(); ++i)
+            out << (i ? ", " : "") << "\"" << params[i].first << "\": " << params[i].second;
+        std::ostringstream times; // Fixed notation without touching the stream's own formatting
+        times << std::fixed << std::setprecision(1) << "\"mean_ns\": " << mean() << ", \"p50_ns\": " << percentile(50)
+              << ", \"p99_ns\": " << percentile(99);
+        out << "},\n     \"samples\": " << samples.size() << ", \"ops_per_sample\": " << opsPerSample << ", "
+            << times.str() << "}";
+    }
+};
+
+/**
+ * Runs the benchmarks and collects their results
+ */
+class MicroBench
+{
+    using Clock = std::chrono::steady_clock;
+
+    std::vector<BenchResult> results;
+    std::string filter;
+    double minSeconds;                  // Time spent sampling each benchmark
+    unsigned seed;
+    std::vector<std::string> packFiles; // Generated packs (and their compiled caches) to delete at the end
+    volatile std::uint64_t sink = 0;    // Keeps the compiler from dropping measured work
+
+    static double elapsedNs(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    }
+
+    bool wanted(const std::string &name) const { return filter.empty() || name.find(filter) != std::string::npos; }
+
+    /**
+     * Time fn(count), which runs count ops, in batches until minSeconds have passed
+     */
+    void runBatched(BenchResult result, size_t batch, const std::function<void(size_t)> &fn)
+    {
+        result.opsPerSample = batch;
+        fn(batch); // Warm up caches and branch predictors
+        auto begin = Clock::now();
+        while (elapsedNs(begin) < minSeconds * 1e9)
+        {
+            auto start = Clock::now();
+            fn(batch);
+            result.samples.push_back(elapsedNs(start) / batch);
+        }
+        report(std::move(result));
+    }
+
+    /**
+     * Time op() one call at a time until minSeconds have passed; prepare() runs untimed before each call
+     */
+    void runSampled(BenchResult result, const std::function<void()> &prepare, const std::function<void()> &op)
+    {
+        auto begin = Clock::now();
+        while (elapsedNs(begin) < minSeconds * 1e9)
+        {
+            prepare();
+            auto start = Clock::now();
+            op();
+            result.samples.push_back(elapsedNs(start));
+        }
+        report(std::move(result));
+    }
+
+    void report(BenchResult result)
+    {
+        std::cerr << std::left << std::setw(26) << result.name << std::right;
+        for (const auto &param : result.params)
+            std::cerr << " " << param.first << "=" << param.second;
+        std::ostringstream p50;
+        p50 << std::fixed << std::setprecision(1) << result.percentile(50);
+        std::cerr << "  p50 " << p50.str() << " ns\n";
+        results.push_back(std::move(result));
+    }
+
+    /**
+     * Write a synthetic pack of a given size: 4 basic elements, then one recipe per
+     * element from two earlier ones
+     * Size 0 stands for the default pack
+     */
+    std::string makePack(size_t elementCount)
+    {
+        if (elementCount == 0)
+            return Simulation::DefaultPackPath;
+        std::string path = "microbench_" + std::to_string(elementCount) + ".pack";
+        std::ofstream out(path);
+        std::mt19937 rng(seed);
+        for (size_t i = 0; i < elementCount; ++i)
+            out << "element E" << i << " | assets/fire.png | Generated element" << (i < 4 ? " | basic\n" : "\n");
+        for (size_t i = 4; i < elementCount; ++i)
+        {
+            std::uniform_int_distribution<size_t> earlier(0, i - 1);
+            out << "recipe E" << earlier(rng) << " + E" << earlier(rng) << " = E" << i << "\n";
+        }
+        packFiles.push_back(path);
+        return path;
+    }
+
+    /**
+     * Object positions spread over a square world with the same density as the bench tool
+     */
+    static float worldSizeFor(size_t objects)
+    {
+        return std::sqrt(static_cast<float>(std::max<size_t>(objects, 1))) * Simulation::DefaultObjectSize * 1.5f;
+    }
+
+    /**
+     * Recipe lookups over a fixed list of pairs, a given fraction of which have a recipe
+     */
+    void benchRegistry(size_t packSize)
+    {
+        Simulation sim(0, makePack(packSize));
+        const CombinationRegistry &registry = sim.registry;
+        std::mt19937 rng(seed);
+
+        // Pairs with and without a recipe (unknown pairs are drawn at random and rejected if they hit)
+        std::vector<std::pair<ElementId, ElementId>> hits, misses;
+        for (size_t i = 0; i < sim.elements.size(); ++i)
+        {
+            for (const CombinationRegistry::Formula &f : registry.getFormulas(static_cast<ElementId>(i)))
+            {
+                if (f.count == 2)
+                    hits.emplace_back(f.ingredients[0], f.ingredients[1]);
+            }
+        }
+        std::uniform_int_distribution<size_t> anyElement(0, sim.elements.size() - 1);
+        while (misses.size() < 4096 && !sim.elements.empty())
+        {
+            ElementId a = static_cast<ElementId>(anyElement(rng)), b = static_cast<ElementId>(anyElement(rng));
+            if (!registry.isValidCombination(a, b))
+                misses.emplace_back(a, b);
+        }
+        if (hits.empty() || misses.empty())
+            return;
+
+        for (double hitRate : {0.0, 0.5, 0.9, 1.0})
+        {
+            std::vector<std::pair<ElementId, ElementId>> pairs(4096);
+            std::uniform_real_distribution<double> chance(0.0, 1.0);
+            for (auto &pair : pairs)
+            {
+                const auto &from = chance(rng) < hitRate ? hits : misses;
+                pair = from[std::uniform_int_distribution<size_t>(0, from.size() - 1)(rng)];
+            }
+
+            BenchResult lookup{"registry.getResult", {{"elements", double(sim.elements.size())}, {"hit_rate", hitRate}}};
+            if (wanted(lookup.name))
+            {
+                size_t next = 0;
+                runBatched(lookup, 1024,
+                           [&](size_t count)
+                           {
+                               for (size_t i = 0; i < count; ++i, next = (next + 1) & 4095)
+                                   sink += registry.getResult(pairs[next].first, pairs[next].second);
+                           });
+            }
+
+            BenchResult valid{"registry.isValidCombination", lookup.params};
+            if (wanted(valid.name))
+            {
+                size_t next = 0;
+                runBatched(valid, 1024,
+                           [&](size_t count)
+                           {
+                               for (size_t i = 0; i < count; ++i, next = (next + 1) & 4095)
+                                   sink += registry.isValidCombination(pairs[next].first, pairs[next].second);
+                           });
+            }
+        }
+    }
+
+    /**
+     * Recipe service requests decoded and answered in memory (no sockets): batches
+     * of random pairs, and makeable sets from a growing number of known elements
+     * Times are per pair and per makeable query
+     */
+    void benchService(size_t packSize)
+    {
+        RecipeService service;
+        if (!service.load(makePack(packSize)) || service.getElementCount() == 0)
+            return;
+        std::mt19937 rng(seed);
+        std::uniform_int_distribution<unsigned> anyElement(0, static_cast<unsigned>(service.getElementCount() - 1));
+        RecipeService::Scratch scratch;
+        std::vector<char> reply;
+
+        auto request = [](std::uint32_t type, const std::vector<ElementId> &ids, std::uint32_t count)
+        {
+            std::vector<char> bytes(sizeof(ServiceHeader) + ids.size() * sizeof(ElementId));
+            ServiceHeader header{type, count};
+            std::memcpy(bytes.data(), &header, sizeof(header));
+            std::memcpy(bytes.data() + sizeof(header), ids.data(), ids.size() * sizeof(ElementId));
+            return bytes;
+        };
+
+        const size_t batch = 256;
+        BenchResult pairs{"service.pairs", {{"elements", double(service.getElementCount())}, {"batch", double(batch)}}};
+        if (wanted(pairs.name))
+        {
+            std::vector<ElementId> ids(2 * batch);
+            for (ElementId &id : ids)
+                id = static_cast<ElementId>(anyElement(rng));
+            std::vector<char> bytes = request(ServiceHeader::PairQuery, ids, batch);
+            runBatched(pairs, batch * 16,
+                       [&](size_t count)
+                       {
+                           for (size_t i = 0; i < count; i += batch)
+                           {
+                               reply.clear();
+                               sink += service.process(bytes.data(), bytes.size(), reply, scratch);
+                           }
+                       });
+        }
+
+        for (size_t known : {size_t(4), size_t(64), size_t(1024)})
+        {
+            BenchResult makeable{"service.makeable", {{"elements", double(service.getElementCount())}, {"known", double(known)}}};
+            if (!wanted(makeable.name) || known > service.getElementCount())
+                continue;
+            std::vector<ElementId> ids(known);
+            for (ElementId &id : ids)
+                id = static_cast<ElementId>(anyElement(rng));
+            std::vector<char> bytes = request(ServiceHeader::MakeableQuery, ids, static_cast<std::uint32_t>(known));
+            runBatched(makeable, 64,
+                       [&](size_t count)
+                       {
+                           for (size_t i = 0; i < count; ++i)
+                           {
+                               reply.clear();
+                               sink += service.process(bytes.data(), bytes.size(), reply, scratch);
+                           }
+                       });
+        }
+    }
+
+    /**
+     * Drop checks with a given number of objects in the sandbox: each op drops a
+     * random object onto another one (a combine attempt) or onto a random spot
+     */
+    void benchCollisions(size_t objects)
+    {
+        BenchResult result{"sim.checkCollisions", {{"objects", double(objects)}}};
+        if (!wanted(result.name))
+            return;
+
+        Simulation sim(objects + 1);
+        std::mt19937 rng(seed);
+        float worldSize = worldSizeFor(objects);
+        std::uniform_real_distribution<float> coord(0.0f, worldSize);
+        std::uniform_int_distribution<size_t> anyElement(0, sim.elements.size() - 1);
+        auto spawnRandom = [&]
+        { sim.spawn(static_cast<ElementId>(anyElement(rng)), sf::Vector2f(coord(rng), coord(rng)), 0.0f); };
+        for (size_t i = 0; i < objects; ++i)
+            spawnRandom();
+
+        ObjectHandle dropped;
+        runSampled(
+            result,
+            [&]
+            {
+                // Combines shrink the sandbox: refill it so every drop sees the same population
+                while (sim.objects.size() < objects)
+                    spawnRandom();
+                std::uniform_int_distribution<size_t> anyObject(0, sim.objects.size() - 1);
+                size_t from = anyObject(rng);
+                sf::Vector2f target = (rng() & 1) ? sim.objects.positions[anyObject(rng)] + sf::Vector2f(10.0f, 10.0f)
+                                                  : sf::Vector2f(coord(rng), coord(rng));
+                sim.beginDrag(sim.objects.handleAt(from));
+                sim.dragTo(target);
+                dropped = sim.endDrag();
+                sim.update(0.0f); // Clears the dimming of the last failed drop
+            },
+            [&] { sink += sim.checkCollisions(dropped, 0.0f).combined; });
+    }
+
+    /**
+     * update() with a full sandbox and one object over the limit, so every call evicts the oldest object
+     */
+    void benchEviction(size_t objects)
+    {
+        BenchResult result{"sim.update.evict", {{"objects", double(objects)}}};
+        if (!wanted(result.name))
+            return;
+
+        Simulation sim(objects);
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<float> coord(0.0f, worldSizeFor(objects));
+        std::uniform_int_distribution<size_t> anyElement(0, sim.elements.size() - 1);
+        auto spawnRandom = [&]
+        { sim.spawn(static_cast<ElementId>(anyElement(rng)), sf::Vector2f(coord(rng), coord(rng)), 0.0f); };
+        for (size_t i = 0; i < objects; ++i)
+            spawnRandom();
+
+        runSampled(result, spawnRandom, [&] { sim.update(0.0f); });
+    }
+
+    /**
+     * Build the sidebar and book row lists of a pack size into a sprite batch,
+     * scrolled to the middle of the list, with every other element discovered
+     */
+    void benchDrawLists(size_t elementCount)
+    {
+        // Two stand-in atlas pages, so the batch splits into runs like the real atlas does
+        sf::Texture pages[2];
+        std::vector<AtlasRegion> icons(elementCount), labels(elementCount);
+        for (size_t i = 0; i < elementCount; ++i)
+        {
+            icons[i] = {&pages[i % 2], sf::IntRect(0, 0, 20, 20)};
+            labels[i] = {&pages[1 - i % 2], sf::IntRect(20, 0, 60, 16)};
+        }
+        std::vector<ElementId> discovered;
+        for (size_t i = 0; i < elementCount; i += 2)
+            discovered.push_back(static_cast<ElementId>(i));
+        const AtlasRegion placeholder{&pages[0], sf::IntRect(0, 20, 20, 20)};
+        const AtlasRegion unknownLabel{&pages[1], sf::IntRect(0, 40, 30, 16)};
+        SpriteBatch batch;
+
+        // Same geometry as the game's sidebar and book lists
+        VirtualList sidebar{{{705, -30, 100, 630}, 10, 30, 600, 50}};
+        sidebar.setCount(discovered.size());
+        sidebar.scrollBy(discovered.size() * 15.0f);
+        BenchResult sidebarResult{"draw.sidebar", {{"elements", double(elementCount)}}};
+        if (wanted(sidebarResult.name))
+        {
+            runBatched(sidebarResult, 64,
+                       [&](size_t count)
+                       {
+                           for (size_t i = 0; i < count; ++i)
+                           {
+                               batch.clear();
+                               queueElementRows(batch, sidebar, 705, 20,
+                                                [&](size_t row, const AtlasRegion *&icon, const AtlasRegion *&label)
+                                                {
+                                                    icon = &icons[discovered[row]];
+                                                    label = &labels[discovered[row]];
+                                                });
+                           }
+                       });
+        }
+
+        VirtualList bookRows{{{130, 100, 100, 380}, 110, 30, 400, 50}};
+        bookRows.setCount(elementCount);
+        bookRows.scrollBy(elementCount * 15.0f);
+        BenchResult bookResult{"draw.book", {{"elements", double(elementCount)}}};
+        if (wanted(bookResult.name))
+        {
+            runBatched(bookResult, 64,
+                       [&](size_t count)
+                       {
+                           for (size_t i = 0; i < count; ++i)
+                           {
+                               batch.clear();
+                               queueElementRows(batch, bookRows, 105, 20,
+                                                [&](size_t row, const AtlasRegion *&icon, const AtlasRegion *&label)
+                                                {
+                                                    bool known = row % 2 == 0;
+                                                    icon = known ? &icons[row] : &placeholder;
+                                                    label = known ? &labels[row] : &unknownLabel;
+                                                });
+                           }
+                       });
+        }
+    }
+
+public:
+    MicroBench(const std::string &nameFilter, double minMs, unsigned s)
+        : filter(nameFilter), minSeconds(minMs / 1000.0), seed(s)
+    {
+    }
+
+    ~MicroBench()
+    {
+        for (const std::string &path : packFiles)
+        {
+            std::remove(path.c_str());
+            std::remove((path + ".bin").c_str());
+        }
+    }
+
+    void run()
+    {
+        for (size_t packSize : {size_t(0), size_t(1000), size_t(10000)}) // 0: the default pack
+            benchRegistry(packSize);
+        for (size_t packSize : {size_t(0), size_t(10000)})
+            benchService(packSize);
+        for (size_t objects : {size_t(50), size_t(1000), size_t(100000)})
+            benchCollisions(objects);
+        for (size_t objects : {size_t(50), size_t(1000), size_t(100000)})
+            benchEviction(objects);
+        for (size_t elements : {size_t(30), size_t(1000), size_t(10000), size_t(50000)})
+            benchDrawLists(elements);
+    }
+
+    void writeJson(std::ostream &out) const
+    {
+        out << "{\"schema\": 1, \"seed\": " << seed << ", \"benchmarks\": [\n";
+        for (size_t i = 0; i < results.size(); ++i)
+        {
+            results[i].writeJson(out);
+            out << (i + 1 < results.size() ? ",\n" : "\n");
+        }
+        out << "]}\n";
+    }
+};
+
+int main(int argc, char **argv)
+{
+    std::string outPath;
+    std::string filter;
+    double minMs = 200.0;
+    unsigned seed = 1;
+    for (int i = 1; i + 1 < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--out") == 0)
+            outPath = argv[++i];
+        else if (std::strcmp(argv[i], "--filter") == 0)
+            filter = argv[++i];
+        else if (std::strcmp(argv[i], "--min-time") == 0)
+            minMs = std::strtod(argv[++i], nullptr);
+        else if (std::strcmp(argv[i], "--seed") == 0)
+            seed = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+    }
+
+    MicroBench bench(filter, minMs, seed);
+    bench.run();
+    if (outPath.empty())
+    {
+        bench.writeJson(std::cout);
+        return 0;
+    }
+    std::ofstream out(outPath);
+    if (!out)
+    {
+        std::cerr << "Failed to open results file: " << outPath << "\n";
+        return 1;
+    }
+    bench.writeJson(out);
+    return out ? 0 : 1;
+}
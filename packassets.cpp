@@ -0,0 +1,45 @@
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "asset_archive.hpp"
+
+/**
+ * Packs the game's images and fonts into one asset archive
+ * Usage: ./packassets [archive [directory or file...]]
+ * Defaults to ./packassets assets.pak assets fonts (run from the game directory,
+ * so entries are stored under the paths the game loads them by)
+ */
+int main(int argc, char **argv)
+{
+    std::string archivePath = argc > 1 ? argv[1] : "assets.pak";
+    std::vector<std::string> inputs;
+    for (int i = 2; i < argc; ++i)
+        inputs.push_back(argv[i]);
+    if (inputs.empty())
+        inputs = {"assets", "fonts"};
+
+    // Directories contribute the files directly inside them
+    std::vector<std::string> files;
+    for (const std::string &input : inputs)
+    {
+        std::error_code error;
+        if (!std::filesystem::is_directory(input, error))
+        {
+            files.push_back(input);
+            continue;
+        }
+        for (const auto &entry : std::filesystem::directory_iterator(input, error))
+        {
+            if (entry.is_regular_file())
+                files.push_back(entry.path().generic_string());
+        }
+        if (error)
+            std::cerr << "Failed to list directory: " << input << "\n";
+    }
+
+    if (!AssetArchive::write(archivePath, files))
+        return 1;
+    std::cout << "Packed " << files.size() << " files into " << archivePath << "\n";
+    return 0;
+}
@@ -0,0 +1,172 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+/**
+ * ParticleSystem animates short-lived effect particles (combination and discovery bursts)
+ * Particles live in a fixed-capacity pool with one array per attribute, so update() is
+ * one tight pass over plain floats that the compiler can vectorize, followed by a pass
+ * that swaps dead particles out. Every live particle is drawn from one vertex array, in
+ * one draw call. New particles are limited by a per-frame budget that shrinks while
+ * frames run long and by the free space of the pool, so under load bursts get sparser
+ * instead of frames getting slower.
+ */
+class ParticleSystem
+{
+public:
+    static constexpr size_t Capacity = 4096; // Most particles alive at once
+
+    /**
+     * Look of one burst
+     */
+    struct Burst
+    {
+        size_t count;    // Particles at full budget and with an empty pool
+        float speed;     // Fastest initial speed in world units per second
+        float life;      // Longest lifetime in seconds
+        float size;      // Side of a particle's square at birth
+        sf::Color color; // Color at birth; particles fade out and shrink as they age
+    };
+
+private:
+    // Per-particle attributes, Capacity each; the first live entries are in use
+    std::vector<float> x, y;       // Centre position
+    std::vector<float> vx, vy;     // Velocity
+    std::vector<float> age;        // Seconds since birth
+    std::vector<float> life;       // Seconds the particle lives
+    std::vector<float> size;       // Side of its square at birth
+    std::vector<sf::Color> colors; // Color at birth
+    size_t live = 0;               // Particles in use
+
+    size_t budget = MaxBudget;           // Particles that may be emitted this frame
+    size_t emitted = 0;                  // Particles emitted since the last update()
+    std::minstd_rand rng{1};             // Fixed seed, so replays look the same
+    sf::VertexArray vertices{sf::Quads}; // Quads of the live particles, rebuilt before drawing
+
+    static constexpr size_t MaxBudget = 1024; // Per-frame emission budget on a fast frame
+    static constexpr size_t MinBudget = 32;   // Budget floor under sustained load
+    static constexpr double TargetMs = 12.0;  // Frame work (excluding the present wait) above which the budget shrinks
+    static constexpr float Gravity = 400.0f;  // Downward acceleration in world units per second squared
+    static constexpr float Drag = 3.0f;       // Fraction of velocity lost per second
+
+    void kill(size_t i)
+    {
+        --live;
+        x[i] = x[live];
+        y[i] = y[live];
+        vx[i] = vx[live];
+        vy[i] = vy[live];
+        age[i] = age[live];
+        life[i] = life[live];
+        size[i] = size[live];
+        colors[i] = colors[live];
+    }
+
+public:
+    ParticleSystem()
+        : x(Capacity), y(Capacity), vx(Capacity), vy(Capacity), age(Capacity), life(Capacity), size(Capacity),
+          colors(Capacity)
+    {
+    }
+
+    size_t getCount() const { return live; }
+    size_t getBudget() const { return budget; }
+
+    /**
+     * Emit a burst of particles flying out from a point
+     * Emits fewer than asked as the pool fills up and once this frame's budget is spent
+     */
+    void burst(sf::Vector2f at, const Burst &look)
+    {
+        size_t room = Capacity - live;
+        size_t count = std::min(look.count * room / Capacity, budget - std::min(budget, emitted));
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+        for (size_t n = 0; n < count; ++n)
+        {
+            float angle = unit(rng) * 6.2831853f;
+            float speed = look.speed * (0.3f + 0.7f * unit(rng));
+            x[live] = at.x;
+            y[live] = at.y;
+            vx[live] = std::cos(angle) * speed;
+            vy[live] = std::sin(angle) * speed;
+            age[live] = 0.0f;
+            life[live] = look.life * (0.5f + 0.5f * unit(rng));
+            size[live] = look.size;
+            colors[live] = look.color;
+            live++;
+        }
+        emitted += count;
+    }
+
+    /**
+     * Advance every particle by dt seconds and retire the ones that expired
+     * Also starts a new frame of emission budget
+     */
+    void update(float dt)
+    {
+        emitted = 0;
+        if (live == 0)
+            return;
+
+        // One pass over plain arrays, no branches
+        const float damping = std::max(0.0f, 1.0f - Drag * dt);
+        const float fall = Gravity * dt;
+        float *px = x.data(), *py = y.data(), *pvx = vx.data(), *pvy = vy.data(), *page = age.data();
+        for (size_t i = 0; i < live; ++i)
+        {
+            pvx[i] *= damping;
+            pvy[i] = pvy[i] * damping + fall;
+            px[i] += pvx[i] * dt;
+            py[i] += pvy[i] * dt;
+            page[i] += dt;
+        }
+
+        // Swap expired particles out (drawing order does not matter, they all share one layer)
+        for (size_t i = 0; i < live;)
+        {
+            if (age[i] >= life[i])
+                kill(i);
+            else
+                ++i;
+        }
+    }
+
+    /**
+     * Adjust the emission budget to the work the last frame took
+     * Halves it when the frame ran over TargetMs and grows it back slowly otherwise
+     */
+    void adaptBudget(double frameWorkMs)
+    {
+        if (frameWorkMs > TargetMs)
+            budget = std::max(MinBudget, budget / 2);
+        else
+            budget = std::min(MaxBudget, budget + budget / 8 + 1);
+    }
+
+    /**
+     * Quads of every live particle, faded and shrunk by age (reuses the array's storage)
+     */
+    const sf::VertexArray &buildVertices()
+    {
+        vertices.resize(live * 4);
+        for (size_t i = 0; i < live; ++i)
+        {
+            float t = age[i] / life[i];
+            float half = size[i] * (1.0f - 0.5f * t) / 2.0f;
+            sf::Color color = colors[i];
+            color.a = static_cast<sf::Uint8>(color.a * (1.0f - t));
+
+            sf::Vertex *quad = &vertices[i * 4];
+            quad[0] = sf::Vertex(sf::Vector2f(x[i] - half, y[i] - half), color);
+            quad[1] = sf::Vertex(sf::Vector2f(x[i] + half, y[i] - half), color);
+            quad[2] = sf::Vertex(sf::Vector2f(x[i] + half, y[i] + half), color);
+            quad[3] = sf::Vertex(sf::Vector2f(x[i] - half, y[i] + half), color);
+        }
+        return vertices;
+    }
+};
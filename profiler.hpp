@@ -0,0 +1,184 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <array>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <string>
+#include <cstdint>
+#include "allocation_counter.hpp"
+
+/**
+ * FrameProfiler measures where each frame's time goes
+ * Times the main loop phases and a few hot sub-scopes, counts draw calls and
+ * heap allocations per frame, shows the results in an overlay and optionally
+ * streams one CSV row per frame for offline analysis
+ */
+class FrameProfiler
+{
+public:
+    /**
+     * Timed scopes; sub-scopes (sidebar, book, collisions) are nested inside a phase
+     */
+    enum Scope
+    {
+        Events,     // Game::handleEvents()
+        Update,     // Game::update()
+        Draw,       // Game::draw() up to presenting the frame
+        Sidebar,    // Right sidebar icons and labels (inside Draw)
+        Book,       // ElementBook::draw() (inside Draw)
+        Collisions, // Simulation::checkCollisions() (inside Events)
+        Particles,  // Effect particle update and vertex building (inside Update and Draw)
+        Present,    // window.display(), including the frame-rate limit wait
+        ScopeCount
+    };
+
+    /**
+     * Everything measured during one frame
+     */
+    struct FrameStats
+    {
+        std::array<double, ScopeCount> ms{}; // Time spent in each scope, in milliseconds
+        double frameMs = 0.0;                // Whole frame, in milliseconds
+        std::uint64_t drawCalls = 0;         // Draw calls issued to the GPU
+        std::uint64_t allocations = 0;       // Heap allocations made during the frame
+        std::size_t objects = 0;             // Objects alive in the sandbox
+    };
+
+    /**
+     * RAII timer adding its lifetime to one scope of the current frame
+     */
+    class ScopedTimer
+    {
+        FrameProfiler &profiler;
+        Scope scope;
+        std::chrono::steady_clock::time_point start;
+
+    public:
+        ScopedTimer(FrameProfiler &p, Scope s) : profiler(p), scope(s), start(std::chrono::steady_clock::now()) {}
+        ~ScopedTimer()
+        {
+            profiler.current.ms[scope] += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+    };
+
+private:
+    FrameStats current;                              // Frame being measured
+    FrameStats last;                                 // Last completed frame
+    FrameStats average;                              // Running average shown in the overlay
+    std::chrono::steady_clock::time_point frameStart;
+    std::uint64_t allocationsAtStart = 0;            // Allocation counter when the frame began
+    std::uint64_t frameIndex = 0;                    // Number of completed frames
+    std::ofstream csv;                               // Optional per-frame CSV stream
+    bool overlayVisible = false;                     // Toggled with F3
+    sf::Text overlayText;                            // Overlay contents (refreshed a few times per second)
+    const int overlayRefreshFrames = 15;             // Frames between overlay text refreshes
+
+    static const char *scopeName(int scope)
+    {
+        static const char *names[ScopeCount] = {"events", "update", "draw", "sidebar", "book", "collisions", "particles", "present"};
+        return names[scope];
+    }
+
+public:
+    /**
+     * Start streaming one row per frame to a CSV file
+     * Returns false if the file cannot be opened
+     */
+    bool openCsv(const std::string &path)
+    {
+        csv.open(path);
+        if (!csv)
+            return false;
+
+        csv << "frame,frame_ms";
+        for (int s = 0; s < ScopeCount; ++s)
+            csv << "," << scopeName(s) << "_ms";
+        csv << ",draw_calls,allocations,objects\n";
+        return true;
+    }
+
+    void setFont(const sf::Font &font)
+    {
+        overlayText.setFont(font);
+        overlayText.setCharacterSize(16);
+        overlayText.setFillColor(sf::Color::White);
+        overlayText.setOutlineColor(sf::Color::Black);
+        overlayText.setOutlineThickness(1.0f);
+        overlayText.setPosition(90, 10);
+    }
+
+    void toggleOverlay() { overlayVisible = !overlayVisible; }
+    bool isOverlayVisible() const { return overlayVisible; }
+
+    void beginFrame()
+    {
+        current = FrameStats();
+        frameStart = std::chrono::steady_clock::now();
+        allocationsAtStart = heapAllocations.load(std::memory_order_relaxed);
+    }
+
+    void endFrame(std::size_t objectCount)
+    {
+        current.frameMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frameStart).count();
+        current.allocations = heapAllocations.load(std::memory_order_relaxed) - allocationsAtStart;
+        current.objects = objectCount;
+        last = current;
+
+        // Exponential moving average keeps the overlay readable
+        const double smoothing = frameIndex == 0 ? 1.0 : 0.1;
+        for (int s = 0; s < ScopeCount; ++s)
+            average.ms[s] += (last.ms[s] - average.ms[s]) * smoothing;
+        average.frameMs += (last.frameMs - average.frameMs) * smoothing;
+
+        if (csv)
+        {
+            csv << frameIndex << "," << last.frameMs;
+            for (int s = 0; s < ScopeCount; ++s)
+                csv << "," << last.ms[s];
+            csv << "," << last.drawCalls << "," << last.allocations << "," << last.objects << "\n";
+        }
+        frameIndex++;
+    }
+
+    /**
+     * Record draw calls issued outside of draw()
+     */
+    void countDrawCalls(std::uint64_t calls) { current.drawCalls += calls; }
+
+    /**
+     * Draw something and count it as one draw call
+     */
+    void draw(sf::RenderTarget &target, const sf::Drawable &drawable, const sf::RenderStates &states = sf::RenderStates::Default)
+    {
+        target.draw(drawable, states);
+        current.drawCalls++;
+    }
+
+    const FrameStats &getLastFrame() const { return last; }
+
+    /**
+     * Draw the overlay (if visible) with averaged timings and last-frame counters
+     */
+    void drawOverlay(sf::RenderTarget &target)
+    {
+        if (!overlayVisible)
+            return;
+
+        if (frameIndex % overlayRefreshFrames == 0 || overlayText.getString().isEmpty())
+        {
+            std::ostringstream text;
+            text << std::fixed << std::setprecision(2);
+            text << "frame " << average.frameMs << " ms\n";
+            for (int s = 0; s < ScopeCount; ++s)
+                text << scopeName(s) << " " << average.ms[s] << " ms\n";
+            text << "draw calls " << last.drawCalls << "\n";
+            text << "allocations " << last.allocations << "\n";
+            text << "objects " << last.objects;
+            overlayText.setString(text.str());
+        }
+        draw(target, overlayText);
+    }
+};
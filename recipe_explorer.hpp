@@ -0,0 +1,346 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <atomic>
+#include <thread>
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <cstdint>
+#include "combination_registry.hpp"
+
+/**
+ * RecipeExplorer searches the recipe graph of a CombinationRegistry
+ * A level-synchronous breadth-first search grows a known set one combination
+ * at a time; large frontiers are split across threads. It answers which
+ * elements a start set can reach and how cheaply, which recipes can never be
+ * used, and what the player could discover next.
+ */
+class RecipeExplorer
+{
+public:
+    static constexpr std::uint32_t NoFormula = 0xFFFFFFFFu;
+
+    /**
+     * Outcome of one search
+     */
+    struct Result
+    {
+        std::vector<int> depths;                 // Combinations needed from the start set (0 for start elements, NoDepth if unreachable)
+        std::vector<std::uint32_t> via;          // Formula that first reaches each element (NoFormula for start and unreachable ones)
+        std::vector<std::uint32_t> deadFormulas; // Formulas with an ingredient the start set can never reach
+        size_t reachable = 0;                    // Elements with a depth, start elements included
+    };
+
+    /**
+     * Suggested next combination
+     */
+    struct Hint
+    {
+        ElementId result = NoElement;                          // Element the formula makes
+        const CombinationRegistry::Formula *formula = nullptr; // Ingredients, all in the current set
+
+        bool isValid() const { return formula != nullptr; }
+    };
+
+private:
+    const CombinationRegistry *registry = nullptr;
+    std::vector<const CombinationRegistry::Formula *> formulas; // Every formula of the registry
+    std::vector<ElementId> resultOf;                             // Result of each formula
+    std::vector<std::uint32_t> useStart;                         // Formulas using element i are uses[useStart[i], useStart[i + 1])
+    std::vector<std::uint32_t> uses;                             // Forward index: formulas by ingredient (once per formula)
+    unsigned threads = 1;                                        // Threads used for large frontiers
+    static constexpr size_t ParallelThreshold = 4096;            // Fewer frontier uses than this run on the calling thread
+
+    static bool firstUse(const CombinationRegistry::Formula &f, std::uint16_t k)
+    {
+        return std::find(f.ingredients, f.ingredients + k, f.ingredients[k]) == f.ingredients + k;
+    }
+
+    /**
+     * Try every formula that uses a range of frontier elements; formulas whose
+     * ingredients are all known by the end of the level claim their result
+     */
+    void expand(const ElementId *first, const ElementId *last, int level, std::vector<std::atomic<int>> &depths,
+                std::vector<std::uint32_t> &via, std::vector<ElementId> &next) const
+    {
+        for (const ElementId *current = first; current != last; ++current)
+        {
+            for (std::uint32_t u = useStart[*current]; u < useStart[*current + 1]; ++u)
+            {
+                std::uint32_t f = uses[u];
+                ElementId result = resultOf[f];
+                if (depths[result].load(std::memory_order_relaxed) != CombinationRegistry::NoDepth)
+                    continue;
+
+                // Ingredients found during this level (depth level + 1) don't count yet
+                const CombinationRegistry::Formula &formula = *formulas[f];
+                bool ready = true;
+                for (std::uint16_t k = 0; k < formula.count && ready; ++k)
+                {
+                    int depth = depths[formula.ingredients[k]].load(std::memory_order_relaxed);
+                    ready = depth != CombinationRegistry::NoDepth && depth <= level;
+                }
+
+                int unseen = CombinationRegistry::NoDepth;
+                if (ready && depths[result].compare_exchange_strong(unseen, level + 1, std::memory_order_relaxed))
+                {
+                    via[result] = f; // Only the thread that claimed the element writes it
+                    next.push_back(result);
+                }
+            }
+        }
+    }
+
+    /**
+     * Call f(formula) for every formula whose ingredients are all in a known set
+     * and whose result is not
+     */
+    template <typename F>
+    void forEachNewFormula(const DiscoverySet &known, F f) const
+    {
+        for (ElementId id : known.getOrder())
+        {
+            if (id >= getElementCount())
+                continue;
+            for (std::uint32_t u = useStart[id]; u < useStart[id + 1]; ++u)
+            {
+                std::uint32_t formula = uses[u];
+                if (known.contains(resultOf[formula]))
+                    continue;
+                bool ready = true;
+                for (std::uint16_t k = 0; k < formulas[formula]->count && ready; ++k)
+                    ready = known.contains(formulas[formula]->ingredients[k]);
+                if (ready)
+                    f(formula);
+            }
+        }
+    }
+
+public:
+    /**
+     * Index the registry's formulas by ingredient (the registry must outlive the explorer)
+     */
+    void build(const CombinationRegistry &reg, size_t elementCount, unsigned threadCount = std::thread::hardware_concurrency())
+    {
+        registry = &reg;
+        threads = std::max(1u, std::min(threadCount, 8u));
+        formulas.clear();
+        resultOf.clear();
+        for (size_t i = 0; i < elementCount; ++i)
+        {
+            for (const CombinationRegistry::Formula &f : reg.getFormulas(static_cast<ElementId>(i)))
+            {
+                formulas.push_back(&f);
+                resultOf.push_back(static_cast<ElementId>(i));
+            }
+        }
+
+        // Counting sort of (ingredient, formula) pairs
+        useStart.assign(elementCount + 1, 0);
+        for (const auto *f : formulas)
+        {
+            for (std::uint16_t k = 0; k < f->count; ++k)
+            {
+                if (firstUse(*f, k))
+                    useStart[f->ingredients[k] + 1]++;
+            }
+        }
+        for (size_t i = 0; i < elementCount; ++i)
+            useStart[i + 1] += useStart[i];
+        uses.resize(useStart[elementCount]);
+        std::vector<std::uint32_t> fill(useStart.begin(), useStart.end() - 1);
+        for (std::uint32_t f = 0; f < formulas.size(); ++f)
+        {
+            for (std::uint16_t k = 0; k < formulas[f]->count; ++k)
+            {
+                if (firstUse(*formulas[f], k))
+                    uses[fill[formulas[f]->ingredients[k]]++] = f;
+            }
+        }
+    }
+
+    size_t getElementCount() const { return useStart.empty() ? 0 : useStart.size() - 1; }
+    size_t getFormulaCount() const { return formulas.size(); }
+    const CombinationRegistry::Formula &getFormula(std::uint32_t f) const { return *formulas[f]; }
+    ElementId getFormulaResult(std::uint32_t f) const { return resultOf[f]; }
+
+    /**
+     * Breadth-first search from a start set
+     * Each level is one more combination; depths are minimal because an element
+     * is claimed at the first level all ingredients of one of its formulas are known
+     */
+    Result explore(const std::vector<ElementId> &start) const
+    {
+        size_t elementCount = getElementCount();
+        std::vector<std::atomic<int>> depths(elementCount);
+        for (auto &depth : depths)
+            depth.store(CombinationRegistry::NoDepth, std::memory_order_relaxed);
+
+        Result result;
+        result.via.assign(elementCount, NoFormula);
+        std::vector<ElementId> frontier;
+        for (ElementId id : start)
+        {
+            if (id < elementCount && depths[id].exchange(0) == CombinationRegistry::NoDepth)
+                frontier.push_back(id);
+        }
+
+        std::vector<std::vector<ElementId>> next(threads);
+        for (int level = 0; !frontier.empty(); ++level)
+        {
+            size_t work = 0;
+            for (ElementId id : frontier)
+                work += useStart[id + 1] - useStart[id];
+
+            if (threads == 1 || work < ParallelThreshold)
+            {
+                next[0].clear();
+                expand(frontier.data(), frontier.data() + frontier.size(), level, depths, result.via, next[0]);
+                frontier.swap(next[0]);
+                continue;
+            }
+
+            // Split the frontier into one contiguous chunk per thread
+            std::vector<std::thread> workers;
+            size_t chunk = (frontier.size() + threads - 1) / threads;
+            for (unsigned t = 0; t < threads; ++t)
+            {
+                next[t].clear();
+                size_t begin = std::min(frontier.size(), t * chunk);
+                size_t end = std::min(frontier.size(), begin + chunk);
+                workers.emplace_back([&, t, begin, end]
+                                     { expand(frontier.data() + begin, frontier.data() + end, level, depths, result.via, next[t]); });
+            }
+            for (auto &worker : workers)
+                worker.join();
+
+            frontier.clear();
+            for (const auto &found : next)
+                frontier.insert(frontier.end(), found.begin(), found.end());
+        }
+
+        result.depths.resize(elementCount);
+        for (size_t i = 0; i < elementCount; ++i)
+        {
+            result.depths[i] = depths[i].load(std::memory_order_relaxed);
+            if (result.depths[i] != CombinationRegistry::NoDepth)
+                result.reachable++;
+        }
+        for (std::uint32_t f = 0; f < formulas.size(); ++f)
+        {
+            for (std::uint16_t k = 0; k < formulas[f]->count; ++k)
+            {
+                if (result.depths[formulas[f]->ingredients[k]] == CombinationRegistry::NoDepth)
+                {
+                    result.deadFormulas.push_back(f);
+                    break;
+                }
+            }
+        }
+        return result;
+    }
+
+    /**
+     * Formulas that make an element from a search's start set, in an order they can be combined
+     * Empty for start and unreachable elements
+     */
+    std::vector<std::uint32_t> path(const Result &result, ElementId target) const
+    {
+        std::vector<std::uint32_t> steps;
+        std::vector<char> visited(getElementCount(), 0);
+
+        // Depth-first over the "via" formulas; a step is emitted after all of its ingredients' steps
+        std::vector<std::pair<ElementId, bool>> work;
+        if (target < visited.size())
+            work.push_back({target, false});
+        while (!work.empty())
+        {
+            auto [id, expanded] = work.back();
+            work.pop_back();
+            std::uint32_t f = result.via[id];
+            if (f == NoFormula)
+                continue;
+            if (expanded)
+            {
+                steps.push_back(f);
+                continue;
+            }
+            if (visited[id])
+                continue;
+            visited[id] = 1;
+            work.push_back({id, true});
+            for (std::uint16_t k = 0; k < formulas[f]->count; ++k)
+            {
+                if (!visited[formulas[f]->ingredients[k]])
+                    work.push_back({formulas[f]->ingredients[k], false});
+            }
+        }
+        return steps;
+    }
+
+    /**
+     * Elements one combination of a known set makes that are not in the set yet, lowest id first
+     * (known must be reset() for at least getElementCount() elements)
+     * Unlike explore() this only looks one step ahead and touches no shared state, so
+     * any number of threads may call it at once (each with its own out vector)
+     */
+    void makeable(const DiscoverySet &known, std::vector<ElementId> &out) const
+    {
+        out.clear();
+        forEachNewFormula(known, [&](std::uint32_t f)
+                          { out.push_back(resultOf[f]); });
+        std::sort(out.begin(), out.end());
+        out.erase(std::unique(out.begin(), out.end()), out.end());
+    }
+
+    /**
+     * Cheapest next discovery from the current discovered set: a formula whose
+     * ingredients are all discovered, making the undiscovered element that is
+     * closest to the basic elements (ties go to the lowest id)
+     * Like makeable() this only looks one step ahead, so it needs no search
+     * (discovered must be reset() for at least getElementCount() elements)
+     */
+    Hint hint(const DiscoverySet &discovered) const
+    {
+        Hint best;
+        int bestDepth = 0;
+        forEachNewFormula(discovered, [&](std::uint32_t f)
+                          {
+                              ElementId result = resultOf[f];
+                              int depth = registry->getDepth(result);
+                              if (!best.isValid() || depth < bestDepth || (depth == bestDepth && result < best.result))
+                              {
+                                  best.result = result;
+                                  best.formula = formulas[f];
+                                  bestDepth = depth;
+                              }
+                          });
+        return best;
+    }
+
+    /**
+     * Print what a start set cannot reach (e.g. for pack validation at load time)
+     * Returns true if every element and recipe is reachable
+     */
+    bool report(const Result &result, const std::vector<std::shared_ptr<Element>> &elements, std::ostream &out) const
+    {
+        size_t unreachable = result.depths.size() - result.reachable;
+        if (unreachable == 0 && result.deadFormulas.empty())
+            return true;
+
+        const size_t listed = 5;
+        out << "Recipe pack check: " << unreachable << " of " << result.depths.size()
+            << " elements cannot be made from the basic ones";
+        size_t shown = 0;
+        for (size_t i = 0; i < result.depths.size() && shown < listed; ++i)
+        {
+            if (result.depths[i] == CombinationRegistry::NoDepth)
+                out << (shown++ ? ", " : " (") << elements[i]->name;
+        }
+        out << (shown ? (unreachable > shown ? ", ...)" : ")") : "") << ", " << result.deadFormulas.size()
+            << " recipes can never be used\n";
+        return false;
+    }
+};
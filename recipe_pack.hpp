@@ -0,0 +1,487 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <fstream>
+#include <iostream>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <sys/stat.h>
+#include "mapped_file.hpp"
+
+/*
+Recipe packs describe every element and recipe of the game in a text file:
+
+    # Comment
+    element <Name> | <image path> | <description> [| basic]
+    recipe <First> + <Second> [+ <Third> [+ <Fourth>]] = <Result>
+
+Basic elements are discovered from the start. Each recipe is written once;
+the ingredients combine in any order.
+
+The first time a pack is loaded it is compiled into a compact binary form
+(interned names, flat recipe hash table) saved next to it as <pack>.bin.
+Later launches memory-map that file and use it as is, without parsing.
+The cache is rebuilt whenever the text pack's size or modification time changes.
+*/
+
+using ElementId = std::uint16_t;    // Dense element id (index in the element list)
+const ElementId NoElement = 0xFFFF; // "No element" sentinel, e.g. for a failed combination
+
+const size_t MaxIngredients = 4; // Most ingredients one recipe can take
+
+/**
+ * Canonical key of an ingredient multiset: the ids sorted ascending, 16 bits each
+ * from the low end, with unused lanes set to NoElement
+ */
+using RecipeKey = std::uint64_t;
+const RecipeKey RecipeEmptyKey = ~RecipeKey(0); // Marks unused table slots (no multiset of 0 ingredients is looked up)
+
+/**
+ * One slot of the open-addressing recipe table, stored as is in the binary pack
+ */
+struct RecipeSlot
+{
+    RecipeKey key;            // Canonical ingredient key, RecipeEmptyKey if unused
+    ElementId result;         // Result of combining the ingredients
+    std::uint16_t padding[3]; // Keeps the on-disk layout explicit
+};
+
+/**
+ * Order-independent key for 2 to MaxIngredients ids
+ * Returns RecipeEmptyKey for any other count, which no lookup ever matches
+ */
+inline RecipeKey recipeKey(const ElementId *ids, size_t count)
+{
+    if (count < 2 || count > MaxIngredients)
+        return RecipeEmptyKey;
+
+    // Insertion sort: at most 4 ids, so this beats any general sort
+    ElementId sorted[MaxIngredients];
+    for (size_t i = 0; i < count; ++i)
+    {
+        size_t j = i;
+        for (; j > 0 && sorted[j - 1] > ids[i]; --j)
+            sorted[j] = sorted[j - 1];
+        sorted[j] = ids[i];
+    }
+
+    RecipeKey key = RecipeEmptyKey;
+    for (size_t i = 0; i < count; ++i)
+        key = (key & ~(RecipeKey(0xFFFF) << (16 * i))) | (RecipeKey(sorted[i]) << (16 * i));
+    return key;
+}
+
+inline RecipeKey recipePairKey(ElementId a, ElementId b)
+{
+    ElementId ids[2] = {a, b};
+    return recipeKey(ids, 2);
+}
+
+/**
+ * Home slot of a key (Fibonacci hashing; the high bits of the product mix every lane)
+ */
+inline std::uint32_t recipeSlotFor(RecipeKey key, std::uint32_t mask)
+{
+    return static_cast<std::uint32_t>((key * 11400714819323198485ull) >> 32) & mask;
+}
+
+/**
+ * RecipePack loads a recipe pack through its binary cache (see the comment above)
+ * and gives read-only access to its elements, recipes and recipe table
+ */
+class RecipePack
+{
+public:
+    static constexpr std::uint32_t FormatVersion = 2;
+
+    /**
+     * Binary pack layout: Header, ElementRecord[elementCount], RecipeRecord[recipeCount],
+     * zero padding up to the table's alignment, RecipeSlot[tableSize], then the string
+     * bytes referenced by the element records
+     */
+    struct Header
+    {
+        char magic[4];              // "LAPK"
+        std::uint32_t version;      // FormatVersion
+        std::uint64_t sourceSize;   // Size of the text pack this was compiled from
+        std::int64_t sourceTime;    // Modification time of the text pack
+        std::uint32_t elementCount; // Number of element records
+        std::uint32_t recipeCount;  // Number of recipe records
+        std::uint32_t tableSize;    // Number of recipe table slots (a power of two)
+        std::uint32_t stringsSize;  // Number of string bytes
+    };
+
+    struct ElementRecord
+    {
+        std::uint32_t nameOffset, nameLength;               // Element name
+        std::uint32_t descriptionOffset, descriptionLength; // Text shown in the element book
+        std::uint32_t textureOffset, textureLength;         // Image path
+        std::uint32_t flags;                                // ElementFlags
+    };
+
+    struct RecipeRecord
+    {
+        ElementId ingredients[MaxIngredients]; // Ingredients as written in the pack, unused ones NoElement
+        ElementId result;
+        std::uint16_t count;                   // Number of ingredients (2 to MaxIngredients)
+    };
+
+    enum ElementFlags : std::uint32_t
+    {
+        ElementBasic = 1 << 0 // Discovered from the start
+    };
+
+private:
+    MappedFile file;          // Mapped binary cache
+    std::vector<char> built;  // Freshly compiled binary (used when the cache was out of date)
+    const Header *header = nullptr;
+    const ElementRecord *elementRecords = nullptr;
+    const RecipeRecord *recipeRecords = nullptr;
+    const RecipeSlot *slots = nullptr;
+    const char *strings = nullptr;
+
+    /**
+     * Element definition while compiling a text pack
+     */
+    struct SourceElement
+    {
+        std::string name;
+        std::string texture;
+        std::string description;
+        bool basic;
+    };
+
+    static std::string trim(const std::string &text)
+    {
+        size_t first = text.find_first_not_of(" \t\r");
+        if (first == std::string::npos)
+            return "";
+        size_t last = text.find_last_not_of(" \t\r");
+        return text.substr(first, last - first + 1);
+    }
+
+    static std::vector<std::string> split(const std::string &text, char separator)
+    {
+        std::vector<std::string> parts;
+        size_t start = 0;
+        while (true)
+        {
+            size_t end = text.find(separator, start);
+            parts.push_back(trim(text.substr(start, end - start)));
+            if (end == std::string::npos)
+                return parts;
+            start = end + 1;
+        }
+    }
+
+    template <typename T>
+    static void append(std::vector<char> &out, const T &value)
+    {
+        const char *bytes = reinterpret_cast<const char *>(&value);
+        out.insert(out.end(), bytes, bytes + sizeof(T));
+    }
+
+    /**
+     * Offset of the recipe table in a binary pack (aligned for its 64-bit keys)
+     */
+    static size_t tableOffset(const Header &h)
+    {
+        size_t end = sizeof(Header) + h.elementCount * sizeof(ElementRecord) + h.recipeCount * sizeof(RecipeRecord);
+        return (end + alignof(RecipeSlot) - 1) & ~(alignof(RecipeSlot) - 1);
+    }
+
+    /**
+     * Parse a text pack and build its binary form
+     */
+    static bool compile(const std::string &path, const struct stat &info, std::vector<char> &out)
+    {
+        std::ifstream in(path);
+        if (!in)
+        {
+            std::cerr << "Failed to open recipe pack: " << path << "\n";
+            return false;
+        }
+
+        std::vector<SourceElement> elements;
+        std::unordered_map<std::string, ElementId> ids;
+        std::vector<std::pair<size_t, std::vector<std::string>>> namedRecipes; // Line number, {ingredients..., result}
+
+        std::string line;
+        size_t lineNumber = 0;
+        while (std::getline(in, line))
+        {
+            lineNumber++;
+            line = trim(line);
+            if (line.empty() || line[0] == '#')
+                continue;
+
+            size_t space = line.find_first_of(" \t");
+            std::string keyword = line.substr(0, space);
+            std::string rest = space == std::string::npos ? "" : trim(line.substr(space));
+
+            if (keyword == "element")
+            {
+                std::vector<std::string> parts = split(rest, '|');
+                bool basic = parts.size() == 4 && parts[3] == "basic";
+                if ((parts.size() != 3 && !basic) || parts[0].empty())
+                {
+                    std::cerr << path << ":" << lineNumber << ": expected 'element Name | image | description [| basic]'\n";
+                    continue;
+                }
+                if (ids.count(parts[0]))
+                {
+                    std::cerr << path << ":" << lineNumber << ": duplicate element " << parts[0] << "\n";
+                    continue;
+                }
+                if (elements.size() >= NoElement)
+                {
+                    std::cerr << path << ":" << lineNumber << ": too many elements\n";
+                    continue;
+                }
+                ids[parts[0]] = static_cast<ElementId>(elements.size());
+                elements.push_back({parts[0], parts[1], parts[2], basic});
+            }
+            else if (keyword == "recipe")
+            {
+                size_t equals = rest.find('=');
+                std::vector<std::string> names = split(rest.substr(0, equals), '+');
+                if (equals == std::string::npos || names.size() < 2 || names.size() > MaxIngredients)
+                {
+                    std::cerr << path << ":" << lineNumber << ": expected 'recipe First + Second [+ Third [+ Fourth]] = Result'\n";
+                    continue;
+                }
+                names.push_back(trim(rest.substr(equals + 1)));
+                namedRecipes.push_back({lineNumber, names});
+            }
+            else
+            {
+                std::cerr << path << ":" << lineNumber << ": unknown keyword " << keyword << "\n";
+            }
+        }
+
+        // Resolve recipe names to ids (recipes may mention elements defined further down)
+        std::vector<RecipeRecord> recipes;
+        for (const auto &named : namedRecipes)
+        {
+            const std::vector<std::string> &n = named.second;
+            RecipeRecord recipe = {{NoElement, NoElement, NoElement, NoElement}, NoElement, static_cast<std::uint16_t>(n.size() - 1)};
+            bool known = true;
+            std::string written;
+            for (size_t i = 0; i < n.size(); ++i)
+            {
+                auto id = ids.find(n[i]);
+                known = known && id != ids.end();
+                if (id != ids.end())
+                    (i + 1 < n.size() ? recipe.ingredients[i] : recipe.result) = id->second;
+                written += (i == 0 ? "" : i + 1 < n.size() ? " + " : " = ") + n[i];
+            }
+            if (!known)
+            {
+                std::cerr << "Recipe references unknown element: " << written << " (" << path << ":" << named.first << ")\n";
+                continue;
+            }
+            recipes.push_back(recipe);
+        }
+
+        // Keep the load factor at or below 50% so probes almost always hit the home slot
+        std::uint32_t capacity = 16;
+        while (capacity < recipes.size() * 2)
+            capacity *= 2;
+        std::vector<RecipeSlot> table(capacity, {RecipeEmptyKey, NoElement, {0, 0, 0}});
+        for (const auto &recipe : recipes)
+        {
+            RecipeKey key = recipeKey(recipe.ingredients, recipe.count);
+            std::uint32_t slot = recipeSlotFor(key, capacity - 1);
+            while (table[slot].key != RecipeEmptyKey && table[slot].key != key)
+                slot = (slot + 1) & (capacity - 1);
+            table[slot] = {key, recipe.result, {0, 0, 0}};
+        }
+
+        // Intern all strings into one blob
+        std::string blob;
+        std::vector<ElementRecord> records;
+        auto intern = [&](const std::string &text, std::uint32_t &offset, std::uint32_t &length)
+        {
+            offset = static_cast<std::uint32_t>(blob.size());
+            length = static_cast<std::uint32_t>(text.size());
+            blob += text;
+        };
+        for (const auto &elem : elements)
+        {
+            ElementRecord record;
+            intern(elem.name, record.nameOffset, record.nameLength);
+            intern(elem.description, record.descriptionOffset, record.descriptionLength);
+            intern(elem.texture, record.textureOffset, record.textureLength);
+            record.flags = elem.basic ? static_cast<std::uint32_t>(ElementBasic) : 0u;
+            records.push_back(record);
+        }
+
+        Header h;
+        std::memcpy(h.magic, "LAPK", 4);
+        h.version = FormatVersion;
+        h.sourceSize = static_cast<std::uint64_t>(info.st_size);
+        h.sourceTime = static_cast<std::int64_t>(info.st_mtime);
+        h.elementCount = static_cast<std::uint32_t>(records.size());
+        h.recipeCount = static_cast<std::uint32_t>(recipes.size());
+        h.tableSize = capacity;
+        h.stringsSize = static_cast<std::uint32_t>(blob.size());
+
+        out.clear();
+        append(out, h);
+        for (const auto &record : records)
+            append(out, record);
+        for (const auto &recipe : recipes)
+            append(out, recipe);
+        out.resize(tableOffset(h), '\0');
+        for (const auto &slot : table)
+            append(out, slot);
+        out.insert(out.end(), blob.begin(), blob.end());
+        return true;
+    }
+
+    /**
+     * Point the accessors at a binary pack if it is well-formed and compiled from the given source
+     */
+    bool attach(const char *data, size_t size, const struct stat &info)
+    {
+        if (size < sizeof(Header))
+            return false;
+
+        const Header *h = reinterpret_cast<const Header *>(data);
+        if (std::memcmp(h->magic, "LAPK", 4) != 0 || h->version != FormatVersion ||
+            h->sourceSize != static_cast<std::uint64_t>(info.st_size) ||
+            h->sourceTime != static_cast<std::int64_t>(info.st_mtime))
+            return false;
+        if (h->tableSize == 0 || (h->tableSize & (h->tableSize - 1)) != 0)
+            return false;
+
+        size_t expected = tableOffset(*h) + size_t(h->tableSize) * sizeof(RecipeSlot) + h->stringsSize;
+        if (size != expected)
+            return false;
+
+        const ElementRecord *e = reinterpret_cast<const ElementRecord *>(data + sizeof(Header));
+        const RecipeRecord *r = reinterpret_cast<const RecipeRecord *>(e + h->elementCount);
+        const RecipeSlot *t = reinterpret_cast<const RecipeSlot *>(data + tableOffset(*h));
+
+        // Bounds-check every reference so a corrupt cache can never be read out of range
+        for (std::uint32_t i = 0; i < h->elementCount; ++i)
+        {
+            if (size_t(e[i].nameOffset) + e[i].nameLength > h->stringsSize ||
+                size_t(e[i].descriptionOffset) + e[i].descriptionLength > h->stringsSize ||
+                size_t(e[i].textureOffset) + e[i].textureLength > h->stringsSize)
+                return false;
+        }
+        for (std::uint32_t i = 0; i < h->recipeCount; ++i)
+        {
+            if (r[i].count < 2 || r[i].count > MaxIngredients || r[i].result >= h->elementCount)
+                return false;
+            for (std::uint16_t k = 0; k < r[i].count; ++k)
+            {
+                if (r[i].ingredients[k] >= h->elementCount)
+                    return false;
+            }
+        }
+        // Lookups probe until they hit an empty slot, so a full table would make every miss spin forever
+        bool hasEmpty = false;
+        for (std::uint32_t i = 0; i < h->tableSize; ++i)
+        {
+            if (t[i].key == RecipeEmptyKey)
+                hasEmpty = true;
+            else if (t[i].result >= h->elementCount)
+                return false;
+        }
+        if (!hasEmpty)
+            return false;
+
+        header = h;
+        elementRecords = e;
+        recipeRecords = r;
+        slots = t;
+        strings = reinterpret_cast<const char *>(t + h->tableSize);
+        return true;
+    }
+
+    std::string text(std::uint32_t offset, std::uint32_t length) const
+    {
+        return std::string(strings + offset, length);
+    }
+
+public:
+    RecipePack() = default;
+    RecipePack(const RecipePack &) = delete;
+    RecipePack &operator=(const RecipePack &) = delete;
+
+    /**
+     * Load a text pack, through its binary cache when that is up to date
+     * useCache = false always compiles the text (the cache check only has a
+     * one-second resolution, too coarse for a pack that is being edited)
+     * Returns false if the pack cannot be read
+     */
+    bool load(const std::string &path, bool useCache = true)
+    {
+        header = nullptr;
+        struct stat info;
+        if (stat(path.c_str(), &info) != 0)
+        {
+            std::cerr << "Failed to open recipe pack: " << path << "\n";
+            return false;
+        }
+
+        // Fast path: map the compiled cache and use it without parsing
+        std::string cachePath = path + ".bin";
+        if (useCache && file.open(cachePath) && attach(file.data(), file.size(), info))
+            return true;
+        file.close();
+
+        // Compile the text pack and save the result for the next launch
+        if (!compile(path, info, built))
+            return false;
+
+        std::string tempPath = cachePath + ".tmp";
+        std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+        out.write(built.data(), static_cast<std::streamsize>(built.size()));
+        out.close();
+        if (!out || !replaceFile(tempPath, cachePath))
+        {
+            std::cerr << "Failed to write recipe pack cache: " << cachePath << "\n";
+            std::remove(tempPath.c_str());
+        }
+
+        return attach(built.data(), built.size(), info);
+    }
+
+    /**
+     * Exchange contents with another pack (data pointers taken from either stay valid)
+     */
+    void swap(RecipePack &other)
+    {
+        file.swap(other.file);
+        built.swap(other.built);
+        std::swap(header, other.header);
+        std::swap(elementRecords, other.elementRecords);
+        std::swap(recipeRecords, other.recipeRecords);
+        std::swap(slots, other.slots);
+        std::swap(strings, other.strings);
+    }
+
+    bool isLoaded() const { return header != nullptr; }
+
+    size_t getElementCount() const { return header ? header->elementCount : 0; }
+    std::string getName(size_t i) const { return text(elementRecords[i].nameOffset, elementRecords[i].nameLength); }
+    std::string getDescription(size_t i) const { return text(elementRecords[i].descriptionOffset, elementRecords[i].descriptionLength); }
+    std::string getTexture(size_t i) const { return text(elementRecords[i].textureOffset, elementRecords[i].textureLength); }
+    bool isBasic(size_t i) const { return (elementRecords[i].flags & ElementBasic) != 0; }
+
+    size_t getRecipeCount() const { return header ? header->recipeCount : 0; }
+    const RecipeRecord &getRecipe(size_t i) const { return recipeRecords[i]; }
+
+    /**
+     * The compiled recipe lookup table (getTableSize() slots, a power of two)
+     */
+    const RecipeSlot *getTable() const { return slots; }
+    std::uint32_t getTableSize() const { return header ? header->tableSize : 0; }
+};
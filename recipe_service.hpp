@@ -0,0 +1,192 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <iostream>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include "recipe_pack.hpp"
+#include "combination_registry.hpp"
+#include "recipe_explorer.hpp"
+
+/*
+Recipe service protocol. A client sends requests over a stream socket and reads
+one reply per request, in the order it sent them. Every request and reply is
+
+    ServiceHeader header              type and count
+    payload                           depends on the type
+
+with integers in the server's native byte order (little-endian, as in the save
+and input log formats):
+
+    PairQuery      request: count pairs of ElementId (a, b)
+                   reply:   count ElementId results, NoElement where there is no recipe
+    MakeableQuery  request: count ElementId known elements (ids past the pack are ignored)
+                   reply:   count ElementId elements one combination of the known ones
+                            makes that are not known yet, lowest id first
+    NamesQuery     request: count 0
+                   reply:   count names in id order, each a uint16 length and its bytes
+    ErrorReply     reply only, count 0: the request was malformed; the server closes
+                   the connection after sending it
+
+Ids are indexes into the pack the server loaded; NamesQuery maps them to names.
+*/
+
+/**
+ * Header of every request and reply
+ */
+struct ServiceHeader
+{
+    static constexpr std::uint32_t PairQuery = 1;
+    static constexpr std::uint32_t MakeableQuery = 2;
+    static constexpr std::uint32_t NamesQuery = 3;
+    static constexpr std::uint32_t ErrorReply = 0xFFFFFFFFu;
+    static constexpr std::uint32_t MaxCount = 65536; // Largest batch a request may carry
+
+    std::uint32_t type;  // One of the query types, or ErrorReply
+    std::uint32_t count; // Pairs, elements or names in the payload
+};
+
+/**
+ * RecipeService answers batched recipe queries against one recipe pack
+ * The pack's compiled table is memory-mapped and nothing changes after load(),
+ * so worker threads share one service without locks; each thread brings its
+ * own Scratch for per-query temporaries
+ */
+class RecipeService
+{
+public:
+    /**
+     * Per-thread temporaries, reused from query to query
+     */
+    struct Scratch
+    {
+        DiscoverySet known;          // Known set of a MakeableQuery
+        std::vector<ElementId> made; // Its reply
+    };
+
+    static constexpr size_t Malformed = static_cast<size_t>(-1); // process() result for a bad request
+
+private:
+    RecipePack pack;                                 // Elements and recipes, mapped from the compiled cache
+    std::vector<std::shared_ptr<Element>> elements; // All elements, indexed by id
+    CombinationRegistry registry;                    // Pair lookups
+    RecipeExplorer explorer;                         // Forward index for makeable sets
+    std::vector<char> namesReply;                    // Reply to NamesQuery, the same for every client
+
+    template <typename T>
+    static void append(std::vector<char> &out, const T &value)
+    {
+        const char *bytes = reinterpret_cast<const char *>(&value);
+        out.insert(out.end(), bytes, bytes + sizeof(T));
+    }
+
+    static void appendIds(std::vector<char> &out, std::uint32_t type, const ElementId *ids, size_t count)
+    {
+        append(out, ServiceHeader{type, static_cast<std::uint32_t>(count)});
+        const char *bytes = reinterpret_cast<const char *>(ids);
+        out.insert(out.end(), bytes, bytes + count * sizeof(ElementId));
+    }
+
+public:
+    RecipeService() = default;
+    RecipeService(const RecipeService &) = delete;
+    RecipeService &operator=(const RecipeService &) = delete;
+
+    /**
+     * Load a recipe pack (through its compiled cache when that is up to date)
+     * Returns false if the pack cannot be read
+     */
+    bool load(const std::string &path)
+    {
+        if (!pack.load(path))
+            return false;
+        elements.clear();
+        for (size_t i = 0; i < pack.getElementCount() && i < NoElement; ++i)
+        {
+            elements.push_back(std::make_shared<Element>(pack.getName(i), pack.getDescription(i), pack.isBasic(i),
+                                                         pack.getTexture(i)));
+        }
+        registry.build(elements, pack);
+        explorer.build(registry, elements.size(), 1); // Queries are one step; threads come from the server
+
+        namesReply.clear();
+        append(namesReply, ServiceHeader{ServiceHeader::NamesQuery, static_cast<std::uint32_t>(elements.size())});
+        for (const auto &elem : elements)
+        {
+            std::uint16_t length = static_cast<std::uint16_t>(std::min<size_t>(elem->name.size(), 0xFFFF));
+            append(namesReply, length);
+            namesReply.insert(namesReply.end(), elem->name.begin(), elem->name.begin() + length);
+        }
+        return true;
+    }
+
+    size_t getElementCount() const { return elements.size(); }
+    const CombinationRegistry &getRegistry() const { return registry; }
+    const RecipeExplorer &getExplorer() const { return explorer; }
+
+    /**
+     * Answer every complete request at the start of in, appending the replies to out
+     * Returns the bytes consumed (a request that has not fully arrived is left for the
+     * next call), or Malformed after appending an ErrorReply
+     */
+    size_t process(const char *in, size_t size, std::vector<char> &out, Scratch &scratch) const
+    {
+        size_t used = 0;
+        while (size - used >= sizeof(ServiceHeader))
+        {
+            ServiceHeader header;
+            std::memcpy(&header, in + used, sizeof(header));
+            size_t entry = header.type == ServiceHeader::PairQuery ? 2 * sizeof(ElementId) : sizeof(ElementId);
+            bool known = header.type == ServiceHeader::PairQuery || header.type == ServiceHeader::MakeableQuery ||
+                         (header.type == ServiceHeader::NamesQuery && header.count == 0);
+            if (!known || header.count > ServiceHeader::MaxCount)
+            {
+                append(out, ServiceHeader{ServiceHeader::ErrorReply, 0});
+                return Malformed;
+            }
+
+            size_t payload = header.count * entry;
+            if (size - used - sizeof(header) < payload)
+                break;
+            const char *data = in + used + sizeof(header);
+            used += sizeof(header) + payload;
+
+            if (header.type == ServiceHeader::PairQuery)
+            {
+                // Results are written straight into the reply (the input may be unaligned, so it is copied out)
+                size_t start = out.size();
+                append(out, ServiceHeader{header.type, header.count});
+                out.resize(out.size() + header.count * sizeof(ElementId));
+                char *results = out.data() + start + sizeof(ServiceHeader);
+                for (std::uint32_t i = 0; i < header.count; ++i)
+                {
+                    ElementId pair[2];
+                    std::memcpy(pair, data + i * sizeof(pair), sizeof(pair));
+                    ElementId result = registry.getResult(pair[0], pair[1]);
+                    std::memcpy(results + i * sizeof(ElementId), &result, sizeof(result));
+                }
+            }
+            else if (header.type == ServiceHeader::MakeableQuery)
+            {
+                scratch.known.reset(elements.size());
+                for (std::uint32_t i = 0; i < header.count; ++i)
+                {
+                    ElementId id;
+                    std::memcpy(&id, data + i * sizeof(id), sizeof(id));
+                    if (id < elements.size())
+                        scratch.known.add(id);
+                }
+                explorer.makeable(scratch.known, scratch.made);
+                appendIds(out, header.type, scratch.made.data(), scratch.made.size());
+            }
+            else
+            {
+                out.insert(out.end(), namesReply.begin(), namesReply.end());
+            }
+        }
+        return used;
+    }
+};
@@ -0,0 +1,280 @@
+#include <vector>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <unordered_map>
+#include <memory>
+#include <algorithm>
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <csignal>
+#include <cerrno>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include "recipe_service.hpp"
+
+/*
+Headless recipe service: answers batched pair lookups and "what can I make"
+queries over TCP (protocol in recipe_service.hpp). Needs no SFML.
+
+Compilation instructions:
+g++ -c recipeserver.cpp -o recipeserver.o -std=c++17 -O2 -pthread
+g++ recipeserver.o -o recipeserver -pthread
+
+Usage:
+./recipeserver [--pack packs/default.pack] [--listen 127.0.0.1] [--port 7878] [--threads N]
+
+Every worker thread owns a listening socket on the same port (SO_REUSEPORT, so
+the kernel spreads new connections over them), its own epoll loop and its own
+connections. The loaded pack is shared read-only, so answering a query takes
+no lock. Linux only (epoll).
+*/
+
+static std::atomic<bool> stopping{false};
+
+/**
+ * One client connection of a worker
+ */
+struct Connection
+{
+    std::vector<char> in;  // Received bytes not answered yet (a request still arriving)
+    std::vector<char> out; // Replies not sent yet
+    size_t sent = 0;       // Bytes of out already sent
+    bool closing = false;  // Close once out is sent (after an ErrorReply)
+};
+
+/**
+ * Worker thread: accepts clients on its own listening socket and serves them
+ */
+class Worker
+{
+    const RecipeService &service;                    // Shared by every worker, read-only
+    int listener = -1;                               // This worker's listening socket
+    int poller = -1;                                 // epoll instance over the listener and the connections
+    std::unordered_map<int, Connection> connections; // Open client connections by socket
+    RecipeService::Scratch scratch;                  // Query temporaries of this thread
+    std::uint64_t answeredBytes = 0;                 // Request bytes answered, for the summary
+
+    void close(int fd)
+    {
+        epoll_ctl(poller, EPOLL_CTL_DEL, fd, nullptr);
+        ::close(fd);
+        connections.erase(fd);
+    }
+
+    /**
+     * Wait for input while nothing is queued, for room to write while replies are
+     * (a client that stops reading is not read from either)
+     */
+    void watch(int fd, const Connection &connection)
+    {
+        epoll_event event{};
+        event.events = connection.sent < connection.out.size() ? EPOLLOUT : EPOLLIN;
+        event.data.fd = fd;
+        epoll_ctl(poller, EPOLL_CTL_MOD, fd, &event);
+    }
+
+    void accept()
+    {
+        while (true)
+        {
+            int fd = accept4(listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0)
+                return;
+            int on = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on)); // Replies are small and latency matters
+            epoll_event event{};
+            event.events = EPOLLIN;
+            event.data.fd = fd;
+            epoll_ctl(poller, EPOLL_CTL_ADD, fd, &event);
+            connections[fd];
+        }
+    }
+
+    /**
+     * Send queued replies; returns false once the connection is gone
+     */
+    bool flush(int fd, Connection &connection)
+    {
+        while (connection.sent < connection.out.size())
+        {
+            ssize_t n = ::send(fd, connection.out.data() + connection.sent, connection.out.size() - connection.sent, MSG_NOSIGNAL);
+            if (n < 0)
+            {
+                if (errno == EAGAIN || errno == EWOULDBLOCK)
+                    return true;
+                return false;
+            }
+            connection.sent += static_cast<size_t>(n);
+        }
+        connection.out.clear();
+        connection.sent = 0;
+        return !connection.closing;
+    }
+
+    /**
+     * Read what arrived, answer every complete request and send the replies
+     */
+    void serve(int fd, Connection &connection)
+    {
+        char buffer[65536];
+        while (connection.out.empty())
+        {
+            ssize_t n = ::recv(fd, buffer, sizeof(buffer), 0);
+            if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK))
+                return close(fd);
+            if (n < 0)
+                break;
+
+            connection.in.insert(connection.in.end(), buffer, buffer + n);
+            size_t used = service.process(connection.in.data(), connection.in.size(), connection.out, scratch);
+            if (used == RecipeService::Malformed)
+            {
+                connection.closing = true;
+                connection.in.clear();
+            }
+            else
+            {
+                answeredBytes += used;
+                connection.in.erase(connection.in.begin(), connection.in.begin() + static_cast<std::ptrdiff_t>(used));
+            }
+            if (!flush(fd, connection))
+                return close(fd);
+        }
+        watch(fd, connection);
+    }
+
+public:
+    explicit Worker(const RecipeService &s) : service(s) {}
+
+    ~Worker()
+    {
+        for (const auto &connection : connections)
+            ::close(connection.first);
+        if (poller >= 0)
+            ::close(poller);
+        if (listener >= 0)
+            ::close(listener);
+    }
+
+    Worker(const Worker &) = delete;
+    Worker &operator=(const Worker &) = delete;
+
+    /**
+     * Bind this worker's listening socket
+     */
+    bool open(const std::string &address, std::uint16_t port)
+    {
+        sockaddr_in bound{};
+        bound.sin_family = AF_INET;
+        bound.sin_port = htons(port);
+        if (inet_pton(AF_INET, address.c_str(), &bound.sin_addr) != 1)
+        {
+            std::cerr << "Invalid listen address: " << address << "\n";
+            return false;
+        }
+
+        int on = 1;
+        listener = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        poller = epoll_create1(EPOLL_CLOEXEC);
+        if (listener < 0 || poller < 0 || setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on)) != 0 ||
+            setsockopt(listener, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on)) != 0 ||
+            bind(listener, reinterpret_cast<const sockaddr *>(&bound), sizeof(bound)) != 0 || listen(listener, 1024) != 0)
+        {
+            std::cerr << "Failed to listen on " << address << ":" << port << ": " << std::strerror(errno) << "\n";
+            return false;
+        }
+
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = listener;
+        epoll_ctl(poller, EPOLL_CTL_ADD, listener, &event);
+        return true;
+    }
+
+    /**
+     * Serve clients until the server is stopped
+     */
+    void run()
+    {
+        epoll_event events[256];
+        while (!stopping.load(std::memory_order_relaxed))
+        {
+            int ready = epoll_wait(poller, events, 256, 200); // Wake now and then to notice stopping
+            for (int i = 0; i < ready; ++i)
+            {
+                int fd = events[i].data.fd;
+                if (fd == listener)
+                {
+                    accept();
+                    continue;
+                }
+                auto it = connections.find(fd);
+                if (it == connections.end())
+                    continue;
+                // Finish sending queued replies before reading more
+                if ((events[i].events & (EPOLLERR | EPOLLHUP) && !(events[i].events & EPOLLIN)) || !flush(fd, it->second))
+                    close(fd);
+                else
+                    serve(fd, it->second);
+            }
+        }
+    }
+
+    std::uint64_t getAnsweredBytes() const { return answeredBytes; }
+};
+
+int main(int argc, char **argv)
+{
+    std::string packPath = "packs/default.pack";
+    std::string address = "127.0.0.1";
+    std::uint16_t port = 7878;
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    for (int i = 1; i + 1 < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--pack") == 0)
+            packPath = argv[++i];
+        else if (std::strcmp(argv[i], "--listen") == 0)
+            address = argv[++i];
+        else if (std::strcmp(argv[i], "--port") == 0)
+            port = static_cast<std::uint16_t>(std::strtoul(argv[++i], nullptr, 10));
+        else if (std::strcmp(argv[i], "--threads") == 0)
+            threads = std::max(1u, static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10)));
+    }
+
+    RecipeService service;
+    if (!service.load(packPath))
+        return 1;
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    for (unsigned t = 0; t < threads; ++t)
+    {
+        workers.push_back(std::make_unique<Worker>(service));
+        if (!workers.back()->open(address, port))
+            return 1;
+    }
+
+    std::signal(SIGINT, [](int)
+                { stopping = true; });
+    std::signal(SIGTERM, [](int)
+                { stopping = true; });
+    std::cerr << "Serving " << service.getElementCount() << " elements from " << packPath << " on " << address << ":"
+              << port << " with " << threads << " threads\n";
+
+    std::vector<std::thread> running;
+    for (auto &worker : workers)
+        running.emplace_back(&Worker::run, worker.get());
+    for (auto &thread : running)
+        thread.join();
+
+    std::uint64_t answered = 0;
+    for (const auto &worker : workers)
+        answered += worker->getAnsweredBytes();
+    std::cerr << "Stopped after answering " << answered << " request bytes\n";
+    return 0;
+}
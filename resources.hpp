@@ -0,0 +1,241 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "asset_archive.hpp"
+
+/**
+ * ResourceManager loads fonts and images once per path and hands out handles
+ * Everything stays owned by the manager, so components keep handles or
+ * references instead of private copies, failed loads share one fallback per
+ * size and colour, and resident memory is measured (and images capped) here
+ */
+class ResourceManager
+{
+public:
+    static constexpr std::uint32_t InvalidIndex = 0xFFFFFFFFu;
+
+    /**
+     * Lightweight reference to a cached font
+     */
+    struct FontHandle
+    {
+        std::uint32_t index = InvalidIndex;
+        bool isValid() const { return index != InvalidIndex; }
+    };
+
+    /**
+     * Lightweight reference to a cached image
+     */
+    struct ImageHandle
+    {
+        std::uint32_t index = InvalidIndex;
+        bool isValid() const { return index != InvalidIndex; }
+    };
+
+private:
+    /**
+     * Cached font; the file bytes stay resident because sf::Font reads glyphs from them on demand
+     */
+    struct FontEntry
+    {
+        std::vector<char> data; // Font file contents (empty for fonts read from the archive's mapping)
+        sf::Font font;
+    };
+
+    /**
+     * Cached image
+     */
+    struct ImageEntry
+    {
+        std::string path;      // Source file, empty for fallbacks
+        sf::Image image;       // Pixels (empty once released)
+        bool released = false; // Pixels were dropped with release()
+    };
+
+    std::vector<std::unique_ptr<FontEntry>> fonts; // Stable addresses, sf::Text keeps pointers to fonts
+    std::vector<ImageEntry> images;
+    std::unordered_map<std::string, std::uint32_t> fontIndex;  // Font entry of each requested path
+    std::unordered_map<std::string, std::uint32_t> imageIndex; // Image entry of each requested path or fallback key
+    size_t fontBytes = 0;                                      // Resident font file data
+    size_t imageBytes = 0;                                     // Resident image pixels
+    size_t imageBudget = static_cast<size_t>(-1);              // Image pixels allowed before loads fall back
+    const AssetArchive *archive;                               // Archive files are read from first (null for loose files only)
+
+    static size_t pixelBytes(const sf::Image &image) { return static_cast<size_t>(image.getSize().x) * image.getSize().y * 4; }
+
+    static bool readFile(const std::string &path, std::vector<char> &data)
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (!file)
+            return false;
+        data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        return !data.empty();
+    }
+
+    /**
+     * Load an image entry's pixels from its path, respecting the budget
+     */
+    bool loadPixels(ImageEntry &entry)
+    {
+        sf::Image image;
+        if (!loadAsset(archive, entry.path, image))
+        {
+            std::cerr << "Failed to load image: " << entry.path << "\n";
+            return false;
+        }
+        if (imageBytes + pixelBytes(image) > imageBudget)
+        {
+            std::cerr << "Image memory budget exceeded, using fallback for " << entry.path << "\n";
+            return false;
+        }
+        entry.image = std::move(image);
+        entry.released = false;
+        imageBytes += pixelBytes(entry.image);
+        return true;
+    }
+
+public:
+    /**
+     * Read files from an archive when it has them (the archive must outlive the manager)
+     */
+    explicit ResourceManager(const AssetArchive *assets = nullptr) : archive(assets) {}
+    ResourceManager(const ResourceManager &) = delete;
+    ResourceManager &operator=(const ResourceManager &) = delete;
+
+    /**
+     * Font for a path, loaded on first request
+     * A font that fails to load resolves to fallbackPath (itself cached), so both
+     * paths end up sharing one font; returns an invalid handle if neither loads
+     */
+    FontHandle loadFont(const std::string &path, const std::string &fallbackPath = "")
+    {
+        auto it = fontIndex.find(path);
+        if (it != fontIndex.end())
+            return {it->second};
+
+        auto entry = std::make_unique<FontEntry>();
+        AssetArchive::Blob blob = archive ? archive->find(path) : AssetArchive::Blob();
+        bool loaded = blob.data ? entry->font.loadFromMemory(blob.data, blob.size) // Glyphs come straight from the mapping
+                                : readFile(path, entry->data) && entry->font.loadFromMemory(entry->data.data(), entry->data.size());
+        if (loaded)
+        {
+            fontBytes += blob.data ? blob.size : entry->data.size();
+            std::uint32_t index = static_cast<std::uint32_t>(fonts.size());
+            fonts.push_back(std::move(entry));
+            fontIndex[path] = index;
+            return {index};
+        }
+
+        if (fallbackPath.empty() || fallbackPath == path)
+        {
+            std::cerr << "Failed to load font from " << path << "\n";
+            return {};
+        }
+        std::cerr << "Failed to load font from " << path << ", using fallback " << fallbackPath << "\n";
+        FontHandle fallback = loadFont(fallbackPath);
+        if (fallback.isValid())
+            fontIndex[path] = fallback.index;
+        return fallback;
+    }
+
+    /**
+     * Font behind a handle (an invalid handle gives SFML's empty font, which draws nothing)
+     */
+    const sf::Font &get(FontHandle handle) const
+    {
+        static const sf::Font empty;
+        return handle.isValid() ? fonts[handle.index]->font : empty;
+    }
+
+    /**
+     * Shared solid-colour image, created once per size and colour
+     */
+    ImageHandle fallbackImage(sf::Vector2u size, sf::Color color)
+    {
+        char key[48];
+        std::snprintf(key, sizeof(key), "fallback:%ux%u:%02x%02x%02x%02x", size.x, size.y, color.r, color.g, color.b, color.a);
+        auto it = imageIndex.find(key);
+        if (it != imageIndex.end())
+            return {it->second};
+
+        ImageEntry entry;
+        entry.image.create(size.x, size.y, color);
+        imageBytes += pixelBytes(entry.image);
+        std::uint32_t index = static_cast<std::uint32_t>(images.size());
+        images.push_back(std::move(entry));
+        imageIndex[key] = index;
+        return {index};
+    }
+
+    /**
+     * Image for a path, loaded on first request
+     * Falls back to the shared fallbackSize/fallbackColor image if the file fails to
+     * load or would exceed the image budget
+     */
+    ImageHandle loadImage(const std::string &path, sf::Vector2u fallbackSize, sf::Color fallbackColor)
+    {
+        auto it = imageIndex.find(path);
+        if (it != imageIndex.end())
+        {
+            ImageEntry &cached = images[it->second];
+            if (!cached.released || loadPixels(cached))
+                return {it->second};
+            return fallbackImage(fallbackSize, fallbackColor);
+        }
+
+        ImageEntry entry;
+        entry.path = path;
+        if (!loadPixels(entry))
+        {
+            ImageHandle fallback = fallbackImage(fallbackSize, fallbackColor);
+            imageIndex[path] = fallback.index; // Don't retry a broken file on every request
+            return fallback;
+        }
+        std::uint32_t index = static_cast<std::uint32_t>(images.size());
+        images.push_back(std::move(entry));
+        imageIndex[path] = index;
+        return {index};
+    }
+
+    /**
+     * Image behind a handle (an invalid or released handle gives an empty image)
+     */
+    const sf::Image &get(ImageHandle handle) const
+    {
+        static const sf::Image empty;
+        return handle.isValid() ? images[handle.index].image : empty;
+    }
+
+    /**
+     * Drop an image's pixels once they live elsewhere (e.g. uploaded to the atlas)
+     * The path stays known, so a later loadImage() reads it again
+     */
+    void release(ImageHandle handle)
+    {
+        if (!handle.isValid() || images[handle.index].path.empty() || images[handle.index].released)
+            return;
+        ImageEntry &entry = images[handle.index];
+        imageBytes -= pixelBytes(entry.image);
+        entry.image = sf::Image();
+        entry.released = true;
+    }
+
+    /**
+     * Cap resident image memory; loads that would go over it get their fallback instead
+     */
+    void setImageBudget(size_t bytes) { imageBudget = bytes; }
+
+    size_t getFontBytes() const { return fontBytes; }
+    size_t getImageBytes() const { return imageBytes; }
+    size_t getFontCount() const { return fonts.size(); }
+    size_t getImageCount() const { return images.size(); }
+};
@@ -1,5 +1,24 @@
 #!/usr/bin/bash
 
-g++ -c main.cpp -o main.o -std=c++17
-g++ main.o -o game -lsfml-graphics -lsfml-window -lsfml-system
-./game
\ No newline at end of file
+g++ -c allocation_counter.cpp -o allocation_counter.o -std=c++17 -O2
+g++ -c main.cpp -o main.o -std=c++17 -pthread
+g++ main.o allocation_counter.o -o game -lsfml-graphics -lsfml-window -lsfml-system -pthread
+
+# Headless simulation benchmark (needs no window or display server)
+g++ -c bench.cpp -o bench.o -std=c++17 -O2 -pthread
+g++ bench.o allocation_counter.o -o bench -pthread
+
+# Micro-benchmarks of the hot paths, results as JSON (./microbench --out results.json)
+g++ -c microbench.cpp -o microbench.o -std=c++17 -O2 -pthread
+g++ microbench.o -o microbench -lsfml-graphics -lsfml-window -lsfml-system -pthread
+
+# Headless recipe service for other backends (./recipeserver --port 7878), needs no SFML
+g++ -c recipeserver.cpp -o recipeserver.o -std=c++17 -O2 -pthread
+g++ recipeserver.o -o recipeserver -pthread
+
+# Packs images and fonts into assets.pak, which the game loads instead of the loose files
+g++ -c packassets.cpp -o packassets.o -std=c++17
+g++ packassets.o -o packassets
+
+./packassets
+./game
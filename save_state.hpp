@@ -0,0 +1,264 @@
+#pragma once
+
+#include <SFML/System/Vector2.hpp>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iostream>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "recipe_pack.hpp"
+#include "mapped_file.hpp"
+
+/*
+Save files hold the player's progress as one compact binary snapshot:
+
+    Header
+    char names[namesSize]                       element names, each '\0'-terminated, in save-time id order
+    std::uint32_t creationCounts[elementCount]  times each element was created
+    ElementId discovered[discoveredCount]       discovered elements, in discovery order
+    float positions[2 * objectCount]            top-left corner (x, y) of each sandbox object, bottom to top
+    ElementId objectElements[objectCount]       element of each sandbox object
+
+Ids are matched to the current pack by name on load, so a save survives
+elements being added or reordered; entries of elements that no longer exist
+are dropped.
+*/
+
+/**
+ * Progress captured from a Simulation (see Simulation::snapshot() and restore())
+ */
+struct SaveState
+{
+    static constexpr std::uint32_t FormatVersion = 1;
+
+    struct Header
+    {
+        char magic[4];                 // "LASV"
+        std::uint32_t version;         // FormatVersion
+        std::uint32_t elementCount;    // Number of names and creation counts
+        std::uint32_t discoveredCount; // Number of discovered ids
+        std::uint32_t objectCount;     // Number of sandbox objects
+        std::uint32_t namesSize;       // Bytes of names, padded to a multiple of 4
+    };
+
+    std::vector<std::string> names;            // Element names, indexed by save-time id
+    std::vector<std::uint32_t> creationCounts; // Creation count of each element, by save-time id
+    std::vector<ElementId> discovered;         // Discovered save-time ids in discovery order
+    std::vector<sf::Vector2f> positions;       // Top-left corner of each object, bottom to top
+    std::vector<ElementId> objectElements;     // Save-time element id of each object
+
+    /**
+     * Encode the snapshot in the save file format
+     */
+    std::vector<char> serialize() const
+    {
+        Header header;
+        std::memcpy(header.magic, "LASV", 4);
+        header.version = FormatVersion;
+        header.elementCount = static_cast<std::uint32_t>(names.size());
+        header.discoveredCount = static_cast<std::uint32_t>(discovered.size());
+        header.objectCount = static_cast<std::uint32_t>(positions.size());
+        header.namesSize = 0;
+        for (const std::string &name : names)
+            header.namesSize += static_cast<std::uint32_t>(name.size() + 1);
+        header.namesSize = (header.namesSize + 3) & ~3u;
+
+        std::vector<char> out;
+        out.reserve(sizeof(Header) + header.namesSize + names.size() * sizeof(std::uint32_t) +
+                    discovered.size() * sizeof(ElementId) + positions.size() * (sizeof(sf::Vector2f) + sizeof(ElementId)));
+        append(out, &header, sizeof(header));
+        size_t namesStart = out.size();
+        for (const std::string &name : names)
+            append(out, name.c_str(), name.size() + 1);
+        out.resize(namesStart + header.namesSize, '\0');
+        append(out, creationCounts.data(), creationCounts.size() * sizeof(std::uint32_t));
+        append(out, discovered.data(), discovered.size() * sizeof(ElementId));
+        append(out, positions.data(), positions.size() * sizeof(sf::Vector2f));
+        append(out, objectElements.data(), objectElements.size() * sizeof(ElementId));
+        return out;
+    }
+
+    /**
+     * Decode a save file image, checking every count against the data size
+     * Returns false (leaving the state unspecified) if the data is not a valid save
+     */
+    bool deserialize(const char *data, size_t size)
+    {
+        Header header;
+        if (size < sizeof(Header))
+            return false;
+        std::memcpy(&header, data, sizeof(Header));
+        if (std::memcmp(header.magic, "LASV", 4) != 0 || header.version != FormatVersion)
+            return false;
+
+        std::uint64_t expected = sizeof(Header) + std::uint64_t(header.namesSize) +
+                                 std::uint64_t(header.elementCount) * sizeof(std::uint32_t) +
+                                 std::uint64_t(header.discoveredCount) * sizeof(ElementId) +
+                                 std::uint64_t(header.objectCount) * (sizeof(sf::Vector2f) + sizeof(ElementId));
+        if (expected != size)
+            return false;
+
+        // Names: elementCount '\0'-terminated strings inside namesSize bytes
+        const char *cursor = data + sizeof(Header);
+        const char *namesEnd = cursor + header.namesSize;
+        names.clear();
+        names.reserve(header.elementCount);
+        for (std::uint32_t i = 0; i < header.elementCount; ++i)
+        {
+            const char *end = static_cast<const char *>(std::memchr(cursor, '\0', namesEnd - cursor));
+            if (!end)
+                return false;
+            names.emplace_back(cursor, end);
+            cursor = end + 1;
+        }
+        cursor = namesEnd;
+
+        read(cursor, creationCounts, header.elementCount);
+        read(cursor, discovered, header.discoveredCount);
+        read(cursor, positions, header.objectCount);
+        read(cursor, objectElements, header.objectCount);
+        return true;
+    }
+
+private:
+    static void append(std::vector<char> &out, const void *bytes, size_t count)
+    {
+        const char *first = static_cast<const char *>(bytes);
+        out.insert(out.end(), first, first + count);
+    }
+
+    template <typename T>
+    static void read(const char *&cursor, std::vector<T> &values, size_t count)
+    {
+        values.resize(count);
+        std::memcpy(values.data(), cursor, count * sizeof(T));
+        cursor += count * sizeof(T);
+    }
+};
+
+/**
+ * Write a snapshot to a save file (through a temporary file, so a crash never leaves half a save)
+ */
+inline bool writeSaveFile(const std::string &path, const SaveState &state)
+{
+    std::vector<char> bytes = state.serialize();
+    std::string tempPath = path + ".tmp";
+    std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+    out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    out.close();
+    if (!out || !replaceFile(tempPath, path))
+    {
+        std::cerr << "Failed to write save file: " << path << "\n";
+        std::remove(tempPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Read a save file
+ * Returns false if it is missing or not a valid save
+ */
+inline bool readSaveFile(const std::string &path, SaveState &state)
+{
+    MappedFile file;
+    if (!file.open(path))
+        return false;
+    if (!state.deserialize(file.data(), file.size()))
+    {
+        std::cerr << "Ignoring invalid or outdated save file: " << path << "\n";
+        return false;
+    }
+    return true;
+}
+
+/**
+ * AutosaveWorker writes snapshots to disk on a background thread
+ * The caller only pays for copying the state; encoding and file I/O happen on
+ * the worker. Snapshots submitted while a write is in progress replace each
+ * other, so only the newest one is written next.
+ */
+class AutosaveWorker
+{
+    const std::string path;       // Save file written by the worker
+    std::mutex mutex;
+    std::condition_variable wake; // Signals the worker that a snapshot arrived (or stopping)
+    std::condition_variable done; // Signals flush() that a write finished
+    SaveState pending;            // Newest snapshot not written yet
+    bool hasPending = false;
+    bool writing = false;         // A snapshot is being written right now
+    bool stopping = false;
+    std::thread worker;           // Started last, once everything it uses is constructed
+
+    void work()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true)
+        {
+            wake.wait(lock, [&]
+                      { return stopping || hasPending; });
+            if (!hasPending)
+                return; // Stopping with nothing left to write
+
+            SaveState state = std::move(pending);
+            hasPending = false;
+            writing = true;
+
+            lock.unlock();
+            writeSaveFile(path, state);
+            lock.lock();
+
+            writing = false;
+            done.notify_all();
+        }
+    }
+
+public:
+    explicit AutosaveWorker(const std::string &savePath) : path(savePath), worker(&AutosaveWorker::work, this) {}
+
+    /**
+     * Write any pending snapshot, then stop the worker
+     */
+    ~AutosaveWorker()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        worker.join();
+    }
+
+    AutosaveWorker(const AutosaveWorker &) = delete;
+    AutosaveWorker &operator=(const AutosaveWorker &) = delete;
+
+    /**
+     * Queue a snapshot to be written (replaces one still waiting)
+     */
+    void submit(SaveState state)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            pending = std::move(state);
+            hasPending = true;
+        }
+        wake.notify_one();
+    }
+
+    /**
+     * Block until every submitted snapshot is on disk
+     */
+    void flush()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [&]
+                  { return !hasPending && !writing; });
+    }
+
+    const std::string &getPath() const { return path; }
+};
@@ -0,0 +1,1276 @@
+#pragma once
+
+#include <SFML/System/Vector2.hpp>
+#include <SFML/Graphics/Rect.hpp>
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <memory>
+#include <algorithm>
+#include <iostream>
+#include <cmath>
+#include <memory_resource>
+#include <cstdint>
+#include "recipe_pack.hpp"
+#include "combination_registry.hpp"
+#include "save_state.hpp"
+
+/*
+Simulation core shared by the game and the headless tools.
+Only uses SFML's header-only vector/rect types, so it needs no window,
+display server or SFML libraries at link time.
+*/
+
+/**
+ * Stable reference to an object in an ObjectPool
+ * The generation changes whenever a slot is reused, so stale handles never alias new objects
+ */
+struct ObjectHandle
+{
+    std::uint32_t slot = 0xFFFFFFFF; // Index into the pool's slot table
+    std::uint32_t generation = 0;    // Generation the slot had when the handle was issued
+
+    bool isNull() const { return slot == 0xFFFFFFFF; }
+    bool operator==(const ObjectHandle &other) const { return slot == other.slot && generation == other.generation; }
+    bool operator!=(const ObjectHandle &other) const { return !(*this == other); }
+    bool operator<(const ObjectHandle &other) const
+    {
+        return slot != other.slot ? slot < other.slot : generation < other.generation;
+    }
+};
+
+namespace std
+{
+    template <>
+    struct hash<ObjectHandle>
+    {
+        size_t operator()(const ObjectHandle &h) const noexcept
+        {
+            return std::hash<std::uint64_t>()((static_cast<std::uint64_t>(h.generation) << 32) | h.slot);
+        }
+    };
+}
+
+/**
+ * Per-object state bits stored in ObjectPool::flags
+ */
+enum ObjectFlags : std::uint8_t
+{
+    ObjectDragging = 1 << 0, // Currently being dragged by the player
+    ObjectDimmed = 1 << 1,   // Semi-transparent after a failed combination
+    ObjectSelected = 1 << 2  // Part of the box selection
+};
+
+/**
+ * ObjectPool stores the interactive element instances in the game world
+ * (the draggable sprites that players can combine) as parallel dense arrays
+ *
+ * Dense index i describes one live object across all arrays; removal swaps the
+ * last object into the hole, so dense indices are not stable - hold an
+ * ObjectHandle to refer to an object across frames. Dense order says nothing
+ * about stacking: objects with a higher drawOrder are drawn later, i.e. on top.
+ */
+class ObjectPool
+{
+    /**
+     * Slot table entry: where a handle's object currently lives
+     */
+    struct Slot
+    {
+        std::uint32_t dense;      // Dense index of the object (valid while alive)
+        std::uint32_t generation; // Bumped every time the slot is freed
+        bool alive;
+    };
+
+    std::vector<Slot> slots;                // Handle slot table
+    std::vector<std::uint32_t> freeSlots;   // Slots available for reuse
+    std::vector<std::uint32_t> denseToSlot; // Back-reference from dense index to slot
+    std::uint64_t nextDrawOrder = 0;        // drawOrder of the next object created
+
+public:
+    // Dense per-object arrays, all of size size(); read and write freely, never resize directly
+    std::vector<sf::Vector2f> positions;  // Top-left corner of each object
+    std::vector<ElementId> elementIds;    // Element type of each object
+    std::vector<float> creationTimes;     // When each object was created (for cleanup)
+    std::vector<std::uint8_t> flags;      // ObjectFlags bits
+    std::vector<std::uint64_t> drawOrder; // Stacking key, increasing with creation (higher is on top)
+
+    size_t size() const { return positions.size(); }
+    bool empty() const { return positions.empty(); }
+
+    /**
+     * Make room for a number of objects without reallocating
+     */
+    void reserve(size_t count)
+    {
+        slots.reserve(count);
+        freeSlots.reserve(count);
+        denseToSlot.reserve(count);
+        positions.reserve(count);
+        elementIds.reserve(count);
+        creationTimes.reserve(count);
+        flags.reserve(count);
+        drawOrder.reserve(count);
+    }
+
+    /**
+     * Create an object and return its handle
+     */
+    ObjectHandle create(ElementId element, sf::Vector2f pos, float time)
+    {
+        std::uint32_t slot;
+        if (!freeSlots.empty())
+        {
+            slot = freeSlots.back();
+            freeSlots.pop_back();
+        }
+        else
+        {
+            slot = static_cast<std::uint32_t>(slots.size());
+            slots.push_back({0, 0, false});
+        }
+
+        slots[slot].dense = static_cast<std::uint32_t>(positions.size());
+        slots[slot].alive = true;
+        denseToSlot.push_back(slot);
+        positions.push_back(pos);
+        elementIds.push_back(element);
+        creationTimes.push_back(time);
+        flags.push_back(0);
+        drawOrder.push_back(nextDrawOrder++);
+        return {slot, slots[slot].generation};
+    }
+
+    bool isAlive(const ObjectHandle &h) const
+    {
+        return h.slot < slots.size() && slots[h.slot].alive && slots[h.slot].generation == h.generation;
+    }
+
+    /**
+     * Dense index of a live object (check isAlive() first)
+     */
+    size_t indexOf(const ObjectHandle &h) const { return slots[h.slot].dense; }
+
+    /**
+     * Handle of the object currently at a dense index
+     */
+    ObjectHandle handleAt(size_t index) const
+    {
+        std::uint32_t slot = denseToSlot[index];
+        return {slot, slots[slot].generation};
+    }
+
+    /**
+     * Whether the object at dense index i is drawn above the one at j
+     */
+    bool isAbove(size_t i, size_t j) const { return drawOrder[i] > drawOrder[j]; }
+
+    /**
+     * Dense indices of every object, bottom to top
+     */
+    std::vector<size_t> stackingOrder() const
+    {
+        std::vector<size_t> order(size());
+        for (size_t i = 0; i < order.size(); ++i)
+            order[i] = i;
+        std::sort(order.begin(), order.end(), [&](size_t a, size_t b)
+                  { return drawOrder[a] < drawOrder[b]; });
+        return order;
+    }
+
+    /**
+     * Remove an object in O(1) by moving the last object into its place
+     */
+    void destroy(const ObjectHandle &h)
+    {
+        if (!isAlive(h))
+            return;
+
+        std::uint32_t index = slots[h.slot].dense;
+        std::uint32_t last = static_cast<std::uint32_t>(positions.size() - 1);
+        if (index != last)
+        {
+            positions[index] = positions[last];
+            elementIds[index] = elementIds[last];
+            creationTimes[index] = creationTimes[last];
+            flags[index] = flags[last];
+            drawOrder[index] = drawOrder[last];
+            denseToSlot[index] = denseToSlot[last];
+            slots[denseToSlot[index]].dense = index;
+        }
+        positions.pop_back();
+        elementIds.pop_back();
+        creationTimes.pop_back();
+        flags.pop_back();
+        drawOrder.pop_back();
+        denseToSlot.pop_back();
+
+        slots[h.slot].alive = false;
+        slots[h.slot].generation++;
+        freeSlots.push_back(h.slot);
+    }
+};
+
+/**
+ * SpatialGrid is a uniform-grid spatial hash over axis-aligned bounds
+ * Each item is linked into every cell its bounds touch, so area queries only
+ * visit nearby cells instead of every item in the world
+ * A cell is a linked list of entries in one shared array; entries and cell map
+ * nodes are recycled as objects are dragged around, so once reserve() has sized
+ * them steady-state moves never reach the heap
+ */
+template <typename T>
+class SpatialGrid
+{
+    /**
+     * An item's entry in one cell
+     */
+    struct Link
+    {
+        T item;
+        std::uint32_t next; // Next entry of the same cell (or of the free list), NoLink at the end
+    };
+    static constexpr std::uint32_t NoLink = 0xFFFFFFFFu;
+
+    float cellSize;                                              // Width and height of one cell in world units
+    std::pmr::unsynchronized_pool_resource pool;                 // Storage of the maps below (declared first)
+    std::pmr::unordered_map<std::uint64_t, std::uint32_t> cells; // First entry of each occupied cell
+    std::pmr::unordered_map<T, sf::IntRect> ranges;              // Range of cells each item is linked into
+    std::vector<Link> links;                                     // Entries of every cell; unused ones chained from freeLink
+    std::uint32_t freeLink = NoLink;                             // First unused entry of links
+
+    static std::uint64_t cellKey(int x, int y)
+    {
+        return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(x)) << 32) | static_cast<std::uint32_t>(y);
+    }
+
+    /**
+     * Range of cells covered by bounds, as (first column, first row, columns, rows)
+     */
+    sf::IntRect cellRange(const sf::FloatRect &bounds) const
+    {
+        int left = static_cast<int>(std::floor(bounds.left / cellSize));
+        int top = static_cast<int>(std::floor(bounds.top / cellSize));
+        int right = static_cast<int>(std::floor((bounds.left + bounds.width) / cellSize));
+        int bottom = static_cast<int>(std::floor((bounds.top + bounds.height) / cellSize));
+        return sf::IntRect(left, top, right - left + 1, bottom - top + 1);
+    }
+
+    void link(const T &item, const sf::IntRect &range)
+    {
+        for (int y = range.top; y < range.top + range.height; ++y)
+        {
+            for (int x = range.left; x < range.left + range.width; ++x)
+            {
+                std::uint32_t &first = cells.try_emplace(cellKey(x, y), NoLink).first->second;
+                std::uint32_t entry = freeLink;
+                if (entry != NoLink)
+                {
+                    freeLink = links[entry].next;
+                    links[entry] = {item, first};
+                }
+                else
+                {
+                    entry = static_cast<std::uint32_t>(links.size());
+                    links.push_back({item, first});
+                }
+                first = entry; // Order inside a cell does not matter, so new entries go first
+            }
+        }
+    }
+
+    void unlink(const T &item, const sf::IntRect &range)
+    {
+        for (int y = range.top; y < range.top + range.height; ++y)
+        {
+            for (int x = range.left; x < range.left + range.width; ++x)
+            {
+                auto cell = cells.find(cellKey(x, y));
+                if (cell == cells.end())
+                    continue;
+
+                std::uint32_t *at = &cell->second;
+                while (*at != NoLink && links[*at].item != item)
+                    at = &links[*at].next;
+                if (*at != NoLink)
+                {
+                    std::uint32_t entry = *at;
+                    *at = links[entry].next;
+                    links[entry].next = freeLink;
+                    freeLink = entry;
+                }
+                if (cell->second == NoLink)
+                    cells.erase(cell);
+            }
+        }
+    }
+
+public:
+    explicit SpatialGrid(float size = 128.0f) : cellSize(size), cells(&pool), ranges(&pool) {}
+
+    SpatialGrid(const SpatialGrid &) = delete;
+    SpatialGrid &operator=(const SpatialGrid &) = delete;
+
+    float getCellSize() const { return cellSize; }
+
+    /**
+     * Make room for a number of items that each touch up to cellsPerItem cells, so
+     * inserting and moving them within that never allocates
+     */
+    void reserve(size_t items, size_t cellsPerItem)
+    {
+        size_t entries = items * cellsPerItem;
+        links.reserve(entries);
+        ranges.reserve(items);
+        cells.reserve(entries);
+
+        // Fill the pool with cell nodes now; cells created later take them from it
+        std::vector<typename std::pmr::unordered_map<std::uint64_t, std::uint32_t>::node_type> nodes;
+        nodes.reserve(entries);
+        for (std::uint64_t key = 0; cells.size() + nodes.size() < entries; ++key)
+        {
+            auto inserted = cells.try_emplace(key, NoLink);
+            if (inserted.second)
+                nodes.push_back(cells.extract(inserted.first));
+        }
+    }
+
+    /**
+     * Add an item covering the given bounds
+     */
+    void insert(const T &item, const sf::FloatRect &bounds)
+    {
+        sf::IntRect range = cellRange(bounds);
+        ranges[item] = range;
+        link(item, range);
+    }
+
+    /**
+     * Move an item to new bounds (cheap when it stays within the same cells)
+     */
+    void update(const T &item, const sf::FloatRect &bounds)
+    {
+        auto it = ranges.find(item);
+        if (it == ranges.end())
+        {
+            insert(item, bounds);
+            return;
+        }
+
+        sf::IntRect range = cellRange(bounds);
+        if (range == it->second)
+            return;
+        unlink(item, it->second);
+        link(item, range);
+        it->second = range;
+    }
+
+    /**
+     * Remove an item from the index
+     */
+    void remove(const T &item)
+    {
+        auto it = ranges.find(item);
+        if (it == ranges.end())
+            return;
+        unlink(item, it->second);
+        ranges.erase(it);
+    }
+
+    void clear()
+    {
+        cells.clear();
+        ranges.clear();
+        links.clear();
+        freeLink = NoLink;
+    }
+
+    /**
+     * Append every item whose cells overlap area to out (each item at most once)
+     * Callers still test exact bounds; this only narrows down the candidates
+     */
+    void query(const sf::FloatRect &area, std::vector<T> &out) const
+    {
+        size_t first = out.size();
+        sf::IntRect range = cellRange(area);
+        for (int y = range.top; y < range.top + range.height; ++y)
+        {
+            for (int x = range.left; x < range.left + range.width; ++x)
+            {
+                auto cell = cells.find(cellKey(x, y));
+                if (cell == cells.end())
+                    continue;
+                for (std::uint32_t entry = cell->second; entry != NoLink; entry = links[entry].next)
+                    out.push_back(links[entry].item);
+            }
+        }
+
+        // Items spanning several cells show up once per cell
+        std::sort(out.begin() + first, out.end());
+        out.erase(std::unique(out.begin() + first, out.end()), out.end());
+    }
+
+    /**
+     * Call f(a, b) once for every pair of items whose bounds (boundsOf(item)) overlap
+     * One sweep over the occupied cells instead of a query per item; a pair sharing
+     * several cells is reported only from the cell holding the top-left corner of
+     * their overlap
+     */
+    template <typename BoundsOf, typename F>
+    void forEachOverlap(BoundsOf boundsOf, F f) const
+    {
+        for (const auto &cell : cells)
+        {
+            int x = static_cast<int>(static_cast<std::uint32_t>(cell.first >> 32));
+            int y = static_cast<int>(static_cast<std::uint32_t>(cell.first));
+            for (std::uint32_t i = cell.second; i != NoLink; i = links[i].next)
+            {
+                sf::FloatRect a = boundsOf(links[i].item);
+                for (std::uint32_t j = links[i].next; j != NoLink; j = links[j].next)
+                {
+                    sf::FloatRect overlap;
+                    if (!a.intersects(boundsOf(links[j].item), overlap))
+                        continue;
+                    sf::IntRect corner = cellRange(sf::FloatRect(overlap.left, overlap.top, 0, 0));
+                    if (corner.left == x && corner.top == y)
+                        f(links[i].item, links[j].item);
+                }
+            }
+        }
+    }
+};
+
+/**
+ * Outcome of dropping an object onto the sandbox
+ */
+struct DropResult
+{
+    bool combined = false;        // Two or more objects were merged into a new one
+    bool invalid = false;         // Overlapped other objects but no recipe matched
+    bool discovered = false;      // The combination produced an element for the first time
+    ElementId result = NoElement; // Element that was created (if combined)
+    ObjectHandle created;         // Newly created object (if combined)
+    sf::Vector2f position;        // Where the new object or the invalid mark appears
+};
+
+/**
+ * What dropping the dragged object where it is would do (see Simulation::previewDrop())
+ */
+struct DropPreview
+{
+    bool overlaps = false;        // The dragged object overlaps at least one other object
+    ElementId result = NoElement; // Element the drop would create (NoElement if it would be invalid)
+    sf::Vector2f position;        // Where the result or the invalid mark would appear
+};
+
+/**
+ * Outcome of Simulation::combineAll()
+ */
+struct CombineAllResult
+{
+    size_t combined = 0;               // Pairs merged into new objects
+    std::vector<ElementId> discovered; // Elements discovered by the merges, in the order they were made
+    std::vector<ObjectHandle> created; // The new objects, one per merge
+};
+
+/**
+ * Simulation holds all game state that does not depend on a window:
+ * elements and their discovery, sandbox objects, the spatial index and recipes
+ * Game drives it from input events; tools can drive it headless
+ */
+class Simulation
+{
+public:
+    RecipePack pack;                                 // Elements and recipes loaded from the pack file
+    std::vector<std::shared_ptr<Element>> elements; // All available elements, indexed by id
+    ObjectPool objects;                              // Active game objects in the world
+    CombinationRegistry registry;                    // Handles element combination logic
+
+private:
+    SpatialGrid<ObjectHandle> grid;                          // Spatial index over object bounds for dropping and picking
+    std::vector<ObjectHandle> nearby;                        // Scratch list of grid query results
+    std::vector<ObjectHandle> overlapping;                   // Scratch list of objects under a dropped one, topmost first
+    std::vector<ObjectHandle> evictionQueue;                 // Objects in creation order, oldest first from evictionHead (may hold stale handles)
+    size_t evictionHead = 0;                                 // First entry of evictionQueue not evicted yet
+    std::vector<ObjectHandle> dimmed;                        // Objects dimmed by the last failed combination
+    std::vector<ObjectHandle> selection;                     // Box-selected objects (may hold stale handles)
+    std::vector<sf::Vector2f> elementSizes;                  // Size of each element's sandbox sprite, by id
+    ObjectHandle draggingObject;                             // Currently dragged object (null handle if none)
+    size_t maxObjects;                                       // Maximum objects allowed in world
+    DiscoverySet discoveredSet;                              // Discovered element ids, in the order they were discovered
+    std::uint64_t revision = 0;                              // Bumped on every change that is visible on screen
+
+    /**
+     * Memoized pair lookup (direct-mapped on the pair's recipe key)
+     */
+    struct PairCacheEntry
+    {
+        RecipeKey key = RecipeEmptyKey; // Pair key, RecipeEmptyKey if unused
+        ElementId result = NoElement;   // Registry result of the pair
+    };
+    static constexpr size_t PairCacheSize = 256;   // Entries in pairCache (a power of two)
+    static constexpr size_t GroupCandidates = 8;   // Topmost objects under a drop tried in groups of 3+ ingredients
+    std::vector<PairCacheEntry> pairCache;         // Recent pair results; a drag keeps hitting the same few pairs
+
+public:
+    static constexpr float DefaultObjectSize = 160.0f; // 320px assets drawn at 50%
+
+    static constexpr const char *DefaultPackPath = "packs/default.pack";
+
+    explicit Simulation(size_t objectLimit = 50, const std::string &packPath = DefaultPackPath) : maxObjects(objectLimit)
+    {
+        // Load elements and recipes (from the compiled pack cache when it is up to date)
+        if (!pack.load(packPath))
+            std::cerr << "Failed to load recipe pack " << packPath << ", starting with no elements\n";
+
+        for (size_t i = 0; i < pack.getElementCount(); ++i)
+        {
+            elements.push_back(std::make_shared<Element>(pack.getName(i), pack.getDescription(i), pack.isBasic(i),
+                                                         pack.getTexture(i)));
+        }
+
+        // Assign dense element ids and attach the compiled recipe table
+        registry.build(elements, pack);
+        pairCache.assign(PairCacheSize, PairCacheEntry());
+        elementSizes.assign(elements.size(), sf::Vector2f(DefaultObjectSize, DefaultObjectSize));
+        reserveForLimit();
+
+        // Basic elements start out discovered
+        discoveredSet.reset(elements.size());
+        for (const auto &elem : elements)
+        {
+            if (elem->discovered)
+            {
+                elem->discovered = false;
+                discover(elem->id);
+            }
+        }
+    }
+
+    /**
+     * Mark an element as discovered (keeps the bitset, the ordered list and Element::discovered in sync)
+     * Returns true if it was not discovered before
+     */
+    bool discover(ElementId element)
+    {
+        if (!discoveredSet.add(element))
+            return false;
+        elements[element]->discovered = true;
+        revision++;
+        return true;
+    }
+
+    bool isDiscovered(ElementId element) const { return discoveredSet.contains(element); }
+
+    /**
+     * Discovered element ids in discovery order (basic elements first)
+     */
+    const std::vector<ElementId> &getDiscovered() const { return discoveredSet.getOrder(); }
+    const DiscoverySet &getDiscoveredSet() const { return discoveredSet; }
+
+    /**
+     * Change the maximum number of objects in the world
+     * Excess objects are evicted oldest first on the next update
+     */
+    void setMaxObjects(size_t limit)
+    {
+        maxObjects = limit;
+        reserveForLimit();
+    }
+    size_t getMaxObjects() const { return maxObjects; }
+
+    /**
+     * Set the sandbox sprite size of an element
+     * Objects of it already in the world are re-indexed at the new size
+     */
+    void setElementSize(ElementId element, sf::Vector2f size)
+    {
+        if (elementSizes[element] == size)
+            return;
+        elementSizes[element] = size;
+        for (size_t i = 0; i < objects.size(); ++i)
+        {
+            if (objects.elementIds[i] == element)
+                grid.update(objects.handleAt(i), objectBounds(i));
+        }
+        revision++;
+    }
+
+    /**
+     * World-space bounds of the object at a dense index
+     */
+    sf::FloatRect objectBounds(size_t index) const
+    {
+        return sf::FloatRect(objects.positions[index], elementSizes[objects.elementIds[index]]);
+    }
+
+    /**
+     * Change counter bumped whenever objects, their flags or discovery change
+     * Compare against a saved value to know whether the sandbox needs repainting
+     */
+    std::uint64_t getRevision() const { return revision; }
+
+    ObjectHandle getDragging() const { return draggingObject; }
+    bool isDragging() const { return objects.isAlive(draggingObject); }
+
+    /**
+     * Create an object of an element in the world (e.g. from the sidebar)
+     */
+    ObjectHandle spawn(ElementId element, sf::Vector2f pos, float time)
+    {
+        elements[element]->creationCount++;
+        return addObject(element, pos, time);
+    }
+
+    /**
+     * Find the topmost object under a point
+     * Returns a null handle if there is none
+     */
+    ObjectHandle pick(sf::Vector2f point)
+    {
+        nearby.clear();
+        grid.query(sf::FloatRect(point.x, point.y, 0, 0), nearby);
+        size_t picked = objects.size();
+        for (const ObjectHandle &h : nearby)
+        {
+            size_t i = objects.indexOf(h);
+            if (objectBounds(i).contains(point) && (picked == objects.size() || objects.isAbove(i, picked)))
+                picked = i;
+        }
+        nearby.clear();
+        return picked < objects.size() ? objects.handleAt(picked) : ObjectHandle();
+    }
+
+    /**
+     * Dense indices of the objects intersecting an area, bottom to top (e.g. what a camera sees)
+     * Only the grid cells under the area are visited, so the cost follows the
+     * number of objects there rather than the size of the world
+     * Indices is any vector of size_t (e.g. a std::pmr::vector backed by a frame arena)
+     */
+    template <typename Indices>
+    void queryArea(const sf::FloatRect &area, Indices &out)
+    {
+        out.clear();
+        nearby.clear();
+        grid.query(area, nearby);
+        for (const ObjectHandle &h : nearby)
+        {
+            size_t i = objects.indexOf(h);
+            if (objectBounds(i).intersects(area))
+                out.push_back(i);
+        }
+        nearby.clear();
+        std::sort(out.begin(), out.end(), [&](size_t a, size_t b)
+                  { return objects.isAbove(b, a); });
+    }
+
+    /**
+     * Start dragging an object
+     */
+    void beginDrag(const ObjectHandle &h)
+    {
+        if (!objects.isAlive(h))
+            return;
+        objects.flags[objects.indexOf(h)] |= ObjectDragging;
+        draggingObject = h;
+        revision++;
+    }
+
+    /**
+     * Move the dragged object so its top-left corner is at pos
+     */
+    void dragTo(sf::Vector2f pos)
+    {
+        if (!objects.isAlive(draggingObject))
+            return;
+        size_t i = objects.indexOf(draggingObject);
+        objects.positions[i] = pos;
+        grid.update(draggingObject, objectBounds(i));
+        revision++;
+    }
+
+    /**
+     * Stop dragging and return the object that was dragged (null handle if none)
+     */
+    ObjectHandle endDrag()
+    {
+        ObjectHandle h = draggingObject;
+        draggingObject = ObjectHandle();
+        if (!objects.isAlive(h))
+            return ObjectHandle();
+        objects.flags[objects.indexOf(h)] &= ~ObjectDragging;
+        revision++;
+        return h;
+    }
+
+    /**
+     * Remove an object from the world and from the spatial index
+     */
+    void removeObject(const ObjectHandle &h)
+    {
+        if (h == draggingObject)
+            draggingObject = ObjectHandle();
+        grid.remove(h);
+        objects.destroy(h);
+        revision++;
+    }
+
+    /**
+     * Remove every object from the world (discovery and creation counts are kept)
+     */
+    void clearObjects()
+    {
+        grid.clear();
+        objects = ObjectPool();
+        evictionQueue.clear();
+        evictionHead = 0;
+        reserveForLimit();
+        dimmed.clear();
+        selection.clear(); // Handles of a fresh pool would match old ones
+        draggingObject = ObjectHandle();
+        revision++;
+    }
+
+    /**
+     * Capture discovery, creation counts and sandbox objects for saving
+     */
+    SaveState snapshot() const
+    {
+        SaveState state;
+        state.names.reserve(elements.size());
+        state.creationCounts.reserve(elements.size());
+        for (const auto &elem : elements)
+        {
+            state.names.push_back(elem->name);
+            state.creationCounts.push_back(static_cast<std::uint32_t>(elem->creationCount));
+        }
+        state.discovered = discoveredSet.getOrder();
+        for (size_t i : objects.stackingOrder())
+        {
+            state.positions.push_back(objects.positions[i]);
+            state.objectElements.push_back(objects.elementIds[i]);
+        }
+        return state;
+    }
+
+    /**
+     * Replace discovery, creation counts and sandbox objects with a saved snapshot
+     * Saved elements are matched by name; basic elements stay discovered even if the
+     * save predates them. Restored objects count as created at the given time.
+     */
+    void restore(const SaveState &state, float time)
+    {
+        // Map save-time ids to current ids (NoElement if the element is gone)
+        std::vector<ElementId> remap(state.names.size(), NoElement);
+        for (size_t i = 0; i < state.names.size(); ++i)
+            remap[i] = registry.getId(state.names[i]);
+        auto current = [&](ElementId saved)
+        { return saved < remap.size() ? remap[saved] : NoElement; };
+
+        for (const auto &elem : elements)
+        {
+            elem->discovered = false;
+            elem->creationCount = 0;
+        }
+        discoveredSet.reset(elements.size());
+        for (ElementId saved : state.discovered)
+        {
+            if (current(saved) != NoElement)
+                discover(current(saved));
+        }
+        for (size_t i = 0; i < elements.size(); ++i)
+        {
+            if (pack.isBasic(i))
+                discover(static_cast<ElementId>(i));
+        }
+        for (size_t i = 0; i < state.names.size(); ++i)
+        {
+            if (remap[i] != NoElement)
+                elements[remap[i]]->creationCount = static_cast<int>(state.creationCounts[i]);
+        }
+
+        // Re-add objects bottom to top so the drawing order is preserved
+        clearObjects();
+        objects.reserve(state.positions.size());
+        for (size_t i = 0; i < state.positions.size(); ++i)
+        {
+            ElementId element = current(state.objectElements[i]);
+            if (element != NoElement)
+                addObject(element, state.positions[i], time);
+        }
+    }
+
+    /**
+     * Switch to a new version of the recipe pack without losing the game
+     * Elements are matched by name: kept ones keep their Element (discovery,
+     * creation count, sprite size) and their objects stay in the world, handles
+     * and all; objects of elements that are gone are removed, and new basic
+     * elements are discovered. remap receives the new id of every old id
+     * (NoElement for removed elements).
+     * Returns false, changing nothing, if the new pack cannot be loaded.
+     */
+    bool reloadPack(const std::string &packPath, std::vector<ElementId> &remap)
+    {
+        RecipePack next;
+        if (!next.load(packPath, false))
+            return false;
+
+        std::unordered_map<std::string, ElementId> oldIds;
+        for (const auto &elem : elements)
+            oldIds[elem->name] = elem->id;
+        remap.assign(elements.size(), NoElement);
+
+        std::vector<std::shared_ptr<Element>> nextElements;
+        std::vector<sf::Vector2f> nextSizes;
+        for (size_t i = 0; i < next.getElementCount() && i < NoElement; ++i)
+        {
+            auto old = oldIds.find(next.getName(i));
+            if (old == oldIds.end())
+            {
+                nextElements.push_back(std::make_shared<Element>(next.getName(i), next.getDescription(i), false,
+                                                                 next.getTexture(i)));
+                nextSizes.emplace_back(DefaultObjectSize, DefaultObjectSize);
+                continue;
+            }
+            std::shared_ptr<Element> elem = elements[old->second];
+            elem->description = next.getDescription(i);
+            elem->texture = next.getTexture(i);
+            remap[old->second] = static_cast<ElementId>(i);
+            nextElements.push_back(elem);
+            nextSizes.push_back(elementSizes[old->second]);
+        }
+
+        pack.swap(next); // The registry below points into the new pack; the old one is freed on return
+        elements = std::move(nextElements);
+        elementSizes = std::move(nextSizes);
+        registry.build(elements, pack);
+        pairCache.assign(PairCacheSize, PairCacheEntry());
+
+        // Objects keep their slots; only their element ids change
+        std::vector<ObjectHandle> gone;
+        for (size_t i = 0; i < objects.size(); ++i)
+        {
+            ElementId element = remap[objects.elementIds[i]];
+            if (element == NoElement)
+                gone.push_back(objects.handleAt(i));
+            else
+                objects.elementIds[i] = element;
+        }
+        for (const ObjectHandle &h : gone)
+            removeObject(h);
+
+        // Rediscover in the same order under the new ids
+        std::vector<ElementId> order = discoveredSet.getOrder();
+        discoveredSet.reset(elements.size());
+        for (const auto &elem : elements)
+            elem->discovered = false;
+        for (ElementId old : order)
+        {
+            if (remap[old] != NoElement)
+                discover(remap[old]);
+        }
+        for (size_t i = 0; i < elements.size(); ++i)
+        {
+            if (pack.isBasic(i))
+                discover(static_cast<ElementId>(i));
+        }
+        revision++;
+        return true;
+    }
+
+    /**
+     * Check for collisions between a dropped object and other objects
+     * Groups of the dropped object and objects under it are tried largest first: every
+     * choice of MaxIngredients - 1 of the topmost objects under it, then of fewer, down
+     * to three ingredients, topmost choices first; if none is a recipe, each object
+     * under it is tried as a pair, topmost first. Handles combinations and reports
+     * invalid ones.
+     */
+    DropResult checkCollisions(ObjectHandle dragged, float time)
+    {
+        DropResult drop;
+        if (!objects.isAlive(dragged))
+            return drop;
+
+        ObjectHandle group[MaxIngredients];
+        ElementId result = NoElement;
+        size_t count = resolveDrop(dragged, group, result);
+        if (count > 2)
+        {
+            combine(group, count, result, time, drop);
+            return drop;
+        }
+
+        // Pairs tried before the one that matched (all of them if none did) are invalid:
+        // report them and make the other objects semi-transparent
+        for (const ObjectHandle &other : overlapping)
+        {
+            if (count == 2 && other == group[1])
+            {
+                combine(group, 2, result, time, drop);
+                break;
+            }
+            size_t i = objects.indexOf(other);
+            drop.invalid = true;
+            drop.position = (objects.positions[objects.indexOf(dragged)] + objects.positions[i]) / 2.0f;
+            objects.flags[i] |= ObjectDimmed;
+            dimmed.push_back(other);
+            revision++;
+        }
+        return drop;
+    }
+
+    /**
+     * What dropping the dragged object right now would do, without changing anything
+     * Meant to run on every mouse move: pair lookups are memoized by element pair
+     */
+    DropPreview previewDrop()
+    {
+        DropPreview preview;
+        if (!objects.isAlive(draggingObject))
+            return preview;
+
+        ObjectHandle group[MaxIngredients];
+        size_t count = resolveDrop(draggingObject, group, preview.result);
+        preview.overlaps = !overlapping.empty();
+        if (count > 0)
+        {
+            // Same spot combine() would use
+            for (size_t k = 0; k < count; ++k)
+                preview.position += objects.positions[objects.indexOf(group[k])];
+            preview.position /= static_cast<float>(count);
+        }
+        else if (preview.overlaps)
+        {
+            // Same spot as the invalid mark of a drop
+            preview.position = (objects.positions[objects.indexOf(draggingObject)] +
+                                objects.positions[objects.indexOf(overlapping.back())]) / 2.0f;
+        }
+        return preview;
+    }
+
+    /**
+     * Replace the selection with the objects intersecting an area
+     * Returns how many objects are selected
+     */
+    size_t select(const sf::FloatRect &area)
+    {
+        clearSelection();
+        std::vector<size_t> inside;
+        queryArea(area, inside);
+        for (size_t i : inside)
+        {
+            objects.flags[i] |= ObjectSelected;
+            selection.push_back(objects.handleAt(i));
+        }
+        revision++;
+        return selection.size();
+    }
+
+    void clearSelection()
+    {
+        for (const ObjectHandle &h : selection)
+        {
+            if (objects.isAlive(h))
+                objects.flags[objects.indexOf(h)] &= ~ObjectSelected;
+        }
+        if (!selection.empty())
+            revision++;
+        selection.clear();
+    }
+
+    /**
+     * Selected objects that still exist
+     */
+    size_t getSelectionCount() const
+    {
+        return std::count_if(selection.begin(), selection.end(), [&](const ObjectHandle &h)
+                             { return objects.isAlive(h); });
+    }
+
+    /**
+     * Merge every overlapping pair of objects that has a recipe, in one pass
+     * Works on the selection, or on every object if nothing is selected. Pairs
+     * are found through the spatial grid; an object joins at most one merge, and
+     * conflicts go to the topmost pair first (by upper, then lower object), the
+     * order a player merging by hand would see. All ingredients are removed
+     * before any result is created, each result at its pair's midpoint; the
+     * results become the new selection, so the action can be repeated.
+     */
+    CombineAllResult combineAll(float time)
+    {
+        CombineAllResult outcome;
+
+        // Candidates by dense index
+        std::vector<char> candidate(objects.size(), selection.empty() ? 1 : 0);
+        for (const ObjectHandle &h : selection)
+        {
+            if (objects.isAlive(h))
+                candidate[objects.indexOf(h)] = 1;
+        }
+        for (size_t i = 0; i < objects.size(); ++i)
+        {
+            if (objects.flags[i] & ObjectDragging)
+                candidate[i] = 0; // The object in the player's hand stays out of it
+        }
+
+        // Every overlapping candidate pair with a recipe, in one sweep over the grid
+        struct Pair
+        {
+            std::uint32_t upper, lower; // Dense indices, upper drawn above lower
+            ElementId result;
+        };
+        std::vector<Pair> pairs;
+        grid.forEachOverlap([&](const ObjectHandle &h)
+                            { return objectBounds(objects.indexOf(h)); },
+                            [&](const ObjectHandle &a, const ObjectHandle &b)
+                            {
+                                size_t i = objects.indexOf(a), j = objects.indexOf(b);
+                                if (!candidate[i] || !candidate[j])
+                                    return;
+                                ElementId result = lookupPair(objects.elementIds[i], objects.elementIds[j]);
+                                if (result == NoElement)
+                                    return;
+                                if (objects.isAbove(j, i))
+                                    std::swap(i, j);
+                                pairs.push_back({static_cast<std::uint32_t>(i), static_cast<std::uint32_t>(j), result});
+                            });
+
+        // Topmost pairs win; every later pair sharing an object is dropped
+        std::sort(pairs.begin(), pairs.end(), [&](const Pair &a, const Pair &b)
+                  { return a.upper != b.upper ? objects.isAbove(a.upper, b.upper) : objects.isAbove(a.lower, b.lower); });
+        std::vector<char> used(objects.size(), 0);
+        struct Merge
+        {
+            ObjectHandle a, b;
+            ElementId result;
+            sf::Vector2f position;
+        };
+        std::vector<Merge> merges;
+        for (const Pair &p : pairs)
+        {
+            if (used[p.upper] || used[p.lower])
+                continue;
+            used[p.upper] = used[p.lower] = 1;
+            merges.push_back({objects.handleAt(p.upper), objects.handleAt(p.lower), p.result,
+                              (objects.positions[p.upper] + objects.positions[p.lower]) / 2.0f});
+        }
+
+        // Apply in one batch: handles stay valid while dense indices shift under the removals
+        clearSelection();
+        for (const Merge &m : merges)
+        {
+            removeObject(m.a);
+            removeObject(m.b);
+        }
+        for (const Merge &m : merges)
+        {
+            if (discover(m.result))
+                outcome.discovered.push_back(m.result);
+            elements[m.result]->creationCount++;
+            ObjectHandle created = addObject(m.result, m.position, time);
+            objects.flags[objects.indexOf(created)] |= ObjectSelected;
+            selection.push_back(created);
+            outcome.created.push_back(created);
+        }
+        outcome.combined = merges.size();
+        return outcome;
+    }
+
+    /**
+     * Update simulation state each frame
+     */
+    void update(float time)
+    {
+        (void)time;
+
+        // Remove oldest objects if over the limit (O(1) each, skipping stale queue entries)
+        ObjectHandle held;
+        while (objects.size() > maxObjects && evictionHead < evictionQueue.size())
+        {
+            ObjectHandle oldest = evictionQueue[evictionHead++];
+            if (!objects.isAlive(oldest))
+                continue; // Already combined or trashed
+            if (oldest == draggingObject)
+            {
+                held = oldest; // Never pull an object out of the player's hand
+                continue;
+            }
+            removeObject(oldest);
+        }
+        if (!held.isNull())
+            evictionQueue[--evictionHead] = held; // Back to the front, in the slot it was taken from
+
+        // Reset dimmed objects to white (remove semi-transparency from failed combinations)
+        // Only the objects dimmed since the last update are touched, not the whole pool
+        for (const ObjectHandle &h : dimmed)
+        {
+            if (objects.isAlive(h))
+                objects.flags[objects.indexOf(h)] &= ~ObjectDimmed;
+        }
+        if (!dimmed.empty())
+        {
+            dimmed.clear();
+            revision++;
+        }
+    }
+
+private:
+    /**
+     * Size the object pool, the scratch lists and the eviction queue for maxObjects,
+     * so a sandbox kept at its limit never reallocates them
+     */
+    void reserveForLimit()
+    {
+        objects.reserve(maxObjects + 1); // One over the limit until update() evicts
+        size_t span = static_cast<size_t>(std::ceil(DefaultObjectSize / grid.getCellSize())) + 1; // Cells a default-size object touches per axis
+        grid.reserve(maxObjects + 1, span * span);
+        nearby.reserve((maxObjects + 1) * span * span); // Grid queries list an object once per cell before deduplicating
+        overlapping.reserve(maxObjects);
+        dimmed.reserve(maxObjects);
+        evictionQueue.reserve(2 * (maxObjects + 1) + 65); // Largest size before addObject() compacts it
+    }
+
+    /**
+     * Registry result of a pair, through the memo
+     */
+    ElementId lookupPair(ElementId a, ElementId b)
+    {
+        RecipeKey key = recipePairKey(a, b);
+        PairCacheEntry &entry = pairCache[recipeSlotFor(key, PairCacheSize - 1)];
+        if (entry.key != key)
+            entry = {key, registry.getResult(a, b)};
+        return entry.result;
+    }
+
+    /**
+     * Work out which objects a drop combines, without changing anything
+     * Fills overlapping with the objects under the dropped one (topmost first) and group
+     * with the objects that combine, dropped object first; returns how many
+     * (0 if no recipe matches), with the element they make in result
+     */
+    size_t resolveDrop(ObjectHandle dragged, ObjectHandle *group, ElementId &result)
+    {
+        size_t draggedIndex = objects.indexOf(dragged);
+        sf::FloatRect draggedBounds = objectBounds(draggedIndex);
+
+        // Only objects sharing a grid cell with the dropped object can overlap it;
+        // order them topmost (highest draw order) first, matching what the player sees
+        nearby.clear();
+        grid.query(draggedBounds, nearby);
+        std::sort(nearby.begin(), nearby.end(), [&](const ObjectHandle &a, const ObjectHandle &b)
+                  { return objects.isAbove(objects.indexOf(a), objects.indexOf(b)); });
+        overlapping.clear();
+        for (const ObjectHandle &other : nearby)
+        {
+            size_t i = objects.indexOf(other);
+            if (other == dragged || (objects.flags[i] & ObjectDragging))
+                continue; // Skip self and other dragging objects
+            if (draggedBounds.intersects(objectBounds(i)))
+                overlapping.push_back(other);
+        }
+        nearby.clear();
+
+        // Try groups of three or more, largest first; within a size, choices of
+        // objects go in lexicographic order of their position in overlapping, so
+        // the topmost ones are tried first (at most C(8, 3) + C(8, 2) lookups)
+        group[0] = dragged;
+        ElementId draggedElement = objects.elementIds[draggedIndex];
+        size_t candidates = std::min(overlapping.size(), GroupCandidates);
+        ElementId under[GroupCandidates];
+        for (size_t k = 0; k < candidates; ++k)
+            under[k] = objects.elementIds[objects.indexOf(overlapping[k])];
+        for (size_t count = std::min(MaxIngredients, candidates + 1); count >= 3; --count)
+        {
+            size_t others = count - 1;
+            size_t chosen[MaxIngredients - 1];
+            for (size_t k = 0; k < others; ++k)
+                chosen[k] = k;
+            while (true)
+            {
+                ElementId ingredients[MaxIngredients] = {draggedElement};
+                for (size_t k = 0; k < others; ++k)
+                    ingredients[k + 1] = under[chosen[k]];
+                result = registry.getResult(ingredients, count);
+                if (result != NoElement)
+                {
+                    for (size_t k = 0; k < others; ++k)
+                        group[k + 1] = overlapping[chosen[k]];
+                    return count;
+                }
+
+                // Advance to the next choice: bump the last index that can still move
+                size_t k = others;
+                while (k > 0 && chosen[k - 1] == candidates - others + k - 1)
+                    --k;
+                if (k == 0)
+                    break;
+                chosen[k - 1]++;
+                for (size_t j = k; j < others; ++j)
+                    chosen[j] = chosen[j - 1] + 1;
+            }
+        }
+
+        // Then each overlapping object as a pair with the dropped one
+        for (const ObjectHandle &other : overlapping)
+        {
+            result = lookupPair(draggedElement, objects.elementIds[objects.indexOf(other)]);
+            if (result != NoElement)
+            {
+                group[1] = other;
+                return 2;
+            }
+        }
+        return 0;
+    }
+
+    /**
+     * Replace a group of objects with one object of the result, at their centroid
+     */
+    void combine(const ObjectHandle *group, size_t count, ElementId result, float time, DropResult &drop)
+    {
+        sf::Vector2f centroid;
+        for (size_t k = 0; k < count; ++k)
+            centroid += objects.positions[objects.indexOf(group[k])];
+        centroid /= static_cast<float>(count);
+
+        // Remove the ingredients (O(1) each) and create the result on top
+        for (size_t k = 0; k < count; ++k)
+            removeObject(group[k]);
+
+        // Ids index straight into the element list
+        drop.discovered = discover(result); // Discover the new element
+        elements[result]->creationCount++;
+        drop.combined = true;
+        drop.invalid = false;
+        drop.result = result;
+        drop.created = addObject(result, centroid, time);
+        drop.position = centroid;
+    }
+
+    /**
+     * Add a new object to the world on top of all existing ones and index it
+     */
+    ObjectHandle addObject(ElementId element, sf::Vector2f pos, float time)
+    {
+        ObjectHandle h = objects.create(element, pos, time);
+        grid.insert(h, objectBounds(objects.indexOf(h)));
+        revision++;
+
+        // Objects are always created with the current time, so appending keeps the queue sorted
+        evictionQueue.push_back(h);
+
+        // Drop evicted entries and handles of objects that were already combined or trashed once
+        // they dominate the queue (so it never outgrows the size reserveForLimit() gives it)
+        if (evictionQueue.size() > 2 * objects.size() + 64)
+        {
+            evictionQueue.erase(std::remove_if(evictionQueue.begin() + static_cast<std::ptrdiff_t>(evictionHead),
+                                               evictionQueue.end(), [&](const ObjectHandle &q)
+                                               { return !objects.isAlive(q); }),
+                                evictionQueue.end());
+            evictionQueue.erase(evictionQueue.begin(), evictionQueue.begin() + static_cast<std::ptrdiff_t>(evictionHead));
+            evictionHead = 0;
+        }
+        return h;
+    }
+};
@@ -0,0 +1,180 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+/**
+ * Location of one packed image: the page texture and its pixel rectangle within it
+ */
+struct AtlasRegion
+{
+    const sf::Texture *page;
+    sf::IntRect rect;
+};
+
+/**
+ * SpriteBatch collects textured quads into one vertex array and draws them
+ * with one draw call per run of quads sharing the same texture page
+ */
+class SpriteBatch
+{
+    sf::VertexArray vertices{sf::Quads};                      // All queued quads, in painter's order
+    std::vector<std::pair<const sf::Texture *, size_t>> runs; // Texture and first vertex of each run
+
+public:
+    /**
+     * Remove all queued quads (keeps the allocated storage for the next frame)
+     */
+    void clear()
+    {
+        vertices.clear();
+        runs.clear();
+    }
+
+    /**
+     * Queue a quad covering dest that samples texRect from texture
+     */
+    void add(const sf::Texture &texture, const sf::IntRect &texRect, const sf::FloatRect &dest, sf::Color color = sf::Color::White)
+    {
+        if (runs.empty() || runs.back().first != &texture)
+            runs.emplace_back(&texture, vertices.getVertexCount());
+
+        float left = static_cast<float>(texRect.left);
+        float top = static_cast<float>(texRect.top);
+        float right = left + texRect.width;
+        float bottom = top + texRect.height;
+
+        vertices.append(sf::Vertex(sf::Vector2f(dest.left, dest.top), color, sf::Vector2f(left, top)));
+        vertices.append(sf::Vertex(sf::Vector2f(dest.left + dest.width, dest.top), color, sf::Vector2f(right, top)));
+        vertices.append(sf::Vertex(sf::Vector2f(dest.left + dest.width, dest.top + dest.height), color, sf::Vector2f(right, bottom)));
+        vertices.append(sf::Vertex(sf::Vector2f(dest.left, dest.top + dest.height), color, sf::Vector2f(left, bottom)));
+    }
+
+    /**
+     * Queue an atlas region stretched over dest
+     */
+    void add(const AtlasRegion &region, const sf::FloatRect &dest, sf::Color color = sf::Color::White)
+    {
+        add(*region.page, region.rect, dest, color);
+    }
+
+    /**
+     * Draw all queued quads, one draw call per texture run
+     * Returns the number of draw calls issued
+     */
+    size_t draw(sf::RenderTarget &target) const
+    {
+        for (size_t i = 0; i < runs.size(); ++i)
+        {
+            size_t first = runs[i].second;
+            size_t last = (i + 1 < runs.size()) ? runs[i + 1].second : vertices.getVertexCount();
+            target.draw(&vertices[first], last - first, sf::Quads, sf::RenderStates(runs[i].first));
+        }
+        return runs.size();
+    }
+};
+
+/**
+ * VirtualList handles a scrolling list of fixed-height rows
+ * The visible index range and the row under the mouse follow arithmetically
+ * from the scroll offset, so the per-frame cost depends on the list's height
+ * and not on how many rows it has
+ */
+class VirtualList
+{
+public:
+    /**
+     * Geometry of a list
+     */
+    struct Layout
+    {
+        sf::FloatRect bounds; // Horizontal extent of the rows; vertical range a row's top edge must be in to be shown
+        float firstRowY;      // Top of row 0 when not scrolled
+        float rowHeight;      // Height of every row
+        float pageHeight;     // Height of the scrolling area
+        float endPadding;     // Extra scroll allowed past the last row
+    };
+
+private:
+    Layout layout;
+    size_t count = 0;    // Number of rows
+    float scroll = 0.0f; // Scroll offset in pixels
+
+public:
+    explicit VirtualList(const Layout &l) : layout(l) {}
+
+    void setCount(size_t rows)
+    {
+        count = rows;
+        scrollBy(0.0f); // Re-clamp in case the list shrank
+    }
+    size_t getCount() const { return count; }
+
+    /**
+     * Scroll by a number of pixels (positive scrolls down), clamped to the list
+     */
+    void scrollBy(float delta)
+    {
+        float maxScroll = std::max(0.0f, count * layout.rowHeight - layout.pageHeight + layout.endPadding);
+        scroll = std::max(0.0f, std::min(scroll + delta, maxScroll));
+    }
+    float getScroll() const { return scroll; }
+
+    float rowY(size_t row) const { return layout.firstRowY + row * layout.rowHeight - scroll; }
+
+    /**
+     * First visible row
+     */
+    size_t beginVisible() const
+    {
+        float first = std::ceil((layout.bounds.top - layout.firstRowY + scroll) / layout.rowHeight);
+        return std::min(count, static_cast<size_t>(std::max(0.0f, first)));
+    }
+
+    /**
+     * One past the last visible row
+     */
+    size_t endVisible() const
+    {
+        float last = std::floor((layout.bounds.top + layout.bounds.height - layout.firstRowY + scroll) / layout.rowHeight);
+        return last < 0 ? 0 : std::min(count, static_cast<size_t>(last) + 1);
+    }
+
+    /**
+     * Visible row containing a point
+     * Returns -1 if the point is not on a visible row
+     */
+    long rowAt(sf::Vector2f point) const
+    {
+        if (point.x < layout.bounds.left || point.x > layout.bounds.left + layout.bounds.width)
+            return -1;
+        float row = std::floor((point.y - layout.firstRowY + scroll) / layout.rowHeight);
+        if (row < beginVisible() || row >= endVisible())
+            return -1;
+        return static_cast<long>(row);
+    }
+};
+
+/**
+ * Queue the icon and name label of every visible row of an element list (the sidebar and the book)
+ * regionsOf(row, icon, label) sets a row's regions, either may be left null to skip it; icons are
+ * iconSize squares at x and labels keep their own size, labelOffset pixels to the right
+ */
+template <typename RegionsOf>
+void queueElementRows(SpriteBatch &batch, const VirtualList &list, float x, float iconSize, RegionsOf regionsOf)
+{
+    const float labelOffset = 25.0f;
+    for (size_t row = list.beginVisible(), end = list.endVisible(); row < end; ++row)
+    {
+        float y = list.rowY(row);
+        const AtlasRegion *icon = nullptr;
+        const AtlasRegion *label = nullptr;
+        regionsOf(row, icon, label);
+        if (icon)
+            batch.add(*icon, sf::FloatRect(x, y, iconSize, iconSize));
+        if (label)
+            batch.add(*label, sf::FloatRect(x + labelOffset, y, label->rect.width, label->rect.height));
+    }
+}